@@ -1,15 +1,36 @@
 #include "devices/input.h"
 #include <debug.h>
-#include "devices/intq.h"
+#include <string.h>
 #include "devices/serial.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
 
-/* Stores keys from the keyboard and serial port. */
-static struct intq buffer;
+/* Stores keys from the keyboard and serial port.
+
+   Received bytes are appended at TAIL by interrupt handlers.  Bytes
+   between HEAD and READY may be read; in canonical mode, the bytes
+   between READY and TAIL are the line still being typed, which
+   becomes readable when a new-line arrives or it fills the buffer.
+   All three counters run freely. */
+#define INPUT_BUFSIZE 1024
+static uint8_t buffer[INPUT_BUFSIZE];
+static size_t head;             /* Next byte to read. */
+static size_t ready;            /* End of readable bytes. */
+static size_t tail;             /* End of received bytes. */
+static enum tty_mode mode;
+
+static struct lock read_lock;   /* Only one thread may read at once. */
+static struct thread *reader;   /* Thread waiting for input. */
+
+static void make_ready (size_t);
+static size_t read_input (void *, size_t, bool wait);
 
 /* Initializes the input buffer. */
 void
 input_init (void) {
-	intq_init (&buffer);
+	lock_init (&read_lock);
+	mode = TTY_RAW;
 }
 
 /* Adds a key to the input buffer.
@@ -17,25 +38,118 @@ input_init (void) {
 void
 input_putc (uint8_t key) {
 	ASSERT (intr_get_level () == INTR_OFF);
-	ASSERT (!intq_full (&buffer));
+	ASSERT (!input_full ());
 
-	intq_putc (&buffer, key);
+	if (mode == TTY_CANON) {
+		if (key == '\b' || key == 0x7f) {
+			/* Erase the last character of the current line. */
+			if (tail > ready)
+				tail--;
+			return;
+		}
+		if (key == '\r')
+			key = '\n';
+	}
+
+	buffer[tail++ % INPUT_BUFSIZE] = key;
+	if (mode == TTY_RAW || key == '\n' || input_full ())
+		make_ready (tail);
 	serial_notify ();
 }
 
+/* Makes the bytes before END readable and wakes up the reader, if
+   any. */
+static void
+make_ready (size_t end) {
+	ready = end;
+	if (reader != NULL) {
+		thread_unblock (reader);
+		reader = NULL;
+	}
+}
+
+/* Reads up to SIZE bytes of input into DST, waiting for input if
+   there is none.  In canonical mode, stops after the end of a line.
+   Returns the number of bytes read, which is 0 only if SIZE is. */
+size_t
+input_read (void *dst, size_t size) {
+	return read_input (dst, size, true);
+}
+
+/* Like input_read(), but returns 0 instead of waiting if no input is
+   ready. */
+size_t
+input_read_nowait (void *dst, size_t size) {
+	return read_input (dst, size, false);
+}
+
+/* Reads up to SIZE bytes of input into DST.  If none is ready, waits
+   for some if WAIT, otherwise returns 0. */
+static size_t
+read_input (void *dst_, size_t size, bool wait) {
+	uint8_t *dst = dst_;
+	size_t cnt = 0;
+
+	if (size == 0)
+		return 0;
+
+	lock_acquire (&read_lock);
+	while (cnt < size) {
+		/* Copy through a bounce buffer, so that a fault on DST
+		   does not happen with interrupts off. */
+		uint8_t chunk[64];
+		size_t chunk_cnt = 0;
+		bool eol = false;
+		enum intr_level old_level = intr_disable ();
+
+		while (head == ready && cnt == 0 && wait) {
+			reader = thread_current ();
+			thread_block ();
+		}
+		while (chunk_cnt < sizeof chunk && cnt + chunk_cnt < size
+				&& head != ready && !eol) {
+			chunk[chunk_cnt] = buffer[head++ % INPUT_BUFSIZE];
+			eol = mode == TTY_CANON && chunk[chunk_cnt] == '\n';
+			chunk_cnt++;
+		}
+		serial_notify ();
+		intr_set_level (old_level);
+
+		if (chunk_cnt == 0)
+			break;
+		memcpy (dst + cnt, chunk, chunk_cnt);
+		cnt += chunk_cnt;
+		if (eol)
+			break;
+	}
+	lock_release (&read_lock);
+
+	return cnt;
+}
+
 /* Retrieves a key from the input buffer.
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t
 input_getc (void) {
-	enum intr_level old_level;
 	uint8_t key;
 
-	old_level = intr_disable ();
-	key = intq_getc (&buffer);
-	serial_notify ();
+	input_read (&key, 1);
+	return key;
+}
+
+/* Switches to input mode NEW_MODE and returns the previous mode.
+   A line being typed when leaving canonical mode becomes readable. */
+enum tty_mode
+input_set_mode (enum tty_mode new_mode) {
+	enum intr_level old_level = intr_disable ();
+	enum tty_mode old_mode = mode;
+
+	mode = new_mode;
+	if (mode == TTY_RAW && ready != tail)
+		make_ready (tail);
 	intr_set_level (old_level);
 
-	return key;
+	return old_mode;
 }
 
 /* Returns true if the input buffer is full,
@@ -44,5 +158,5 @@ input_getc (void) {
 bool
 input_full (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
-	return intq_full (&buffer);
+	return tail - head == INPUT_BUFSIZE;
 }
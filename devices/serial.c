@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -51,12 +51,30 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted.
+
+   Any number of threads, and interrupt handlers, append to this ring
+   at TX_TAIL; the transmit interrupt takes bytes from TX_HEAD.  Both
+   counters run freely.  Producers copy whole buffers in with
+   interrupts disabled, so writers never take a sleeping lock here and
+   the port is reprogrammed once per buffer rather than once per
+   byte.  A thread that finds the ring full sleeps on TX_ROOM until
+   the interrupt handler has drained half of it. */
+#define TXQ_SIZE 4096
+static uint8_t txq[TXQ_SIZE];
+static size_t tx_head;          /* Next byte to transmit. */
+static size_t tx_tail;          /* Next free slot. */
+static struct semaphore tx_room;
+static int tx_waiters;          /* Threads sleeping on TX_ROOM. */
+
+static inline bool txq_empty (void) { return tx_head == tx_tail; }
+static inline size_t txq_room (void) { return TXQ_SIZE - (tx_tail - tx_head); }
+static inline uint8_t txq_getc (void) { return txq[tx_head++ % TXQ_SIZE]; }
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
+static void write_chunk (const uint8_t *, size_t);
 static intr_handler_func serial_interrupt;
 
 /* Initializes the serial port device for polling mode.
@@ -70,7 +88,7 @@ init_poll (void) {
 	outb (FCR_REG, 0);                    /* Disable FIFO. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	sema_init (&tx_room, 0);
 	mode = POLL;
 }
 
@@ -95,28 +113,70 @@ serial_init_queue (void) {
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
+	serial_write (&byte, 1);
+}
+
+/* Bytes serial_write() copies out of its caller's buffer at a
+   time. */
+#define WRITE_CHUNK 64
+
+/* Sends the N bytes in BUFFER to the serial port.  In queued mode
+   this returns as soon as they are in the transmit ring.
+
+   BUFFER may be user memory, which must not be touched with
+   interrupts off, so it is copied to the stack a chunk at a time
+   and interrupts are disabled only while a chunk is queued. */
+void
+serial_write (const void *buffer, size_t n) {
+	const uint8_t *p = buffer;
+	uint8_t chunk[WRITE_CHUNK];
+
+	while (n > 0) {
+		size_t cnt = n < sizeof chunk ? n : sizeof chunk;
+
+		memcpy (chunk, p, cnt);
+		write_chunk (chunk, cnt);
+		p += cnt;
+		n -= cnt;
+	}
+}
+
+/* Sends the N bytes in kernel buffer P to the serial port. */
+static void
+write_chunk (const uint8_t *p, size_t n) {
 	enum intr_level old_level = intr_disable ();
 
 	if (mode != QUEUE) {
 		/* If we're not set up for interrupt-driven I/O yet,
-		   use dumb polling to transmit a byte. */
+		   use dumb polling to transmit. */
 		if (mode == UNINIT)
 			init_poll ();
-		putc_poll (byte);
+		while (n-- > 0)
+			putc_poll (*p++);
 	} else {
-		/* Otherwise, queue a byte and update the interrupt enable
-		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
+		while (n > 0) {
+			size_t chunk = n < txq_room () ? n : txq_room ();
+
+			if (chunk == 0) {
+				/* The ring is full.  With interrupts on, wait for
+				   the transmit interrupt to make room.  Otherwise
+				   that would have to reenable interrupts, which is
+				   impolite, so send a byte by polling instead. */
+				if (old_level == INTR_ON) {
+					tx_waiters++;
+					sema_down (&tx_room);
+				} else
+					putc_poll (txq_getc ());
+				continue;
+			}
+
+			for (size_t i = 0; i < chunk; i++)
+				txq[(tx_tail + i) % TXQ_SIZE] = p[i];
+			tx_tail += chunk;
+			p += chunk;
+			n -= chunk;
+			write_ier ();
 		}
-
-		intq_putc (&txq, byte);
-		write_ier ();
 	}
 
 	intr_set_level (old_level);
@@ -127,8 +187,8 @@ serial_putc (uint8_t byte) {
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
-	while (!intq_empty (&txq))
-		putc_poll (intq_getc (&txq));
+	while (!txq_empty ())
+		putc_poll (txq_getc ());
 	intr_set_level (old_level);
 }
 
@@ -171,7 +231,7 @@ write_ier (void) {
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
-	if (!intq_empty (&txq))
+	if (!txq_empty ())
 		ier |= IER_XMIT;
 
 	/* Enable receive interrupt if we have room to store any
@@ -207,8 +267,13 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 
 	/* As long as we have a byte to transmit, and the hardware is
 	   ready to accept a byte for transmission, transmit a byte. */
-	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-		outb (THR_REG, intq_getc (&txq));
+	while (!txq_empty () && (inb (LSR_REG) & LSR_THRE) != 0)
+		outb (THR_REG, txq_getc ());
+
+	/* Wake writers waiting for room once half the ring is free. */
+	if (tx_waiters > 0 && txq_room () >= TXQ_SIZE / 2)
+		for (; tx_waiters > 0; tx_waiters--)
+			sema_up (&tx_room);
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
@@ -25,6 +25,7 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+static void putc_no_cursor (int c);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -52,7 +53,46 @@ vga_putc (int c) {
 	enum intr_level old_level = intr_disable ();
 
 	init ();
+	putc_no_cursor (c);
+	move_cursor ();
+
+	intr_set_level (old_level);
+}
+
+/* Characters vga_write() copies out of its caller's buffer at a
+   time. */
+#define WRITE_CHUNK 64
+
+/* Writes the N characters in BUFFER to the VGA text display, like
+   vga_putc(), but moves the hardware cursor once per chunk rather
+   than per character.  BUFFER may be user memory, which must not be
+   touched with interrupts off, so it is copied to the stack first,
+   and interrupts are enabled again between chunks. */
+void
+vga_write (const char *buffer, size_t n) {
+	char chunk[WRITE_CHUNK];
+
+	while (n > 0) {
+		size_t cnt = n < sizeof chunk ? n : sizeof chunk;
+		enum intr_level old_level;
+
+		memcpy (chunk, buffer, cnt);
+		buffer += cnt;
+		n -= cnt;
+
+		old_level = intr_disable ();
+		init ();
+		for (size_t i = 0; i < cnt; i++)
+			putc_no_cursor (chunk[i]);
+		move_cursor ();
+		intr_set_level (old_level);
+	}
+}
 
+/* Writes C to the framebuffer without updating the hardware
+   cursor. */
+static void
+putc_no_cursor (int c) {
 	switch (c) {
 		case '\n':
 			newline ();
@@ -84,11 +124,6 @@ vga_putc (int c) {
 				newline ();
 			break;
 	}
-
-	/* Update cursor position. */
-	move_cursor ();
-
-	intr_set_level (old_level);
 }
 
 /* Clears the screen and moves the cursor to the upper left. */
@@ -0,0 +1,338 @@
+#include "filesys/cache.h"
+#include <debug.h>
+#include <hash.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Buffer cache of file system sectors.
+
+   CACHE_SIZE sectors are kept in memory, indexed by sector number.
+   Writes only dirty the cached copy: dirty sectors go to disk when
+   they are evicted, when the file they belong to is closed or synced,
+   every FLUSH_INTERVAL along with the free map, and at shutdown.
+   Writing a whole sector never reads it first.  Readers ask for the
+   following sector to be read ahead by a background thread.
+
+   CACHE_LOCK protects the index, the clock hand and the PIN_CNT of
+   every entry.  An entry's own LOCK is held while its data is read,
+   written or transferred to or from disk.  A pinned entry is never
+   evicted, and only a pinned entry's lock is ever held, so an
+   unpinned entry's lock is always free. */
+
+struct cache_entry {
+	disk_sector_t sector;       /* Sector cached here. */
+	bool valid;                 /* DATA holds SECTOR's contents? */
+	bool dirty;                 /* DATA newer than the disk? */
+	bool accessed;              /* Used since the clock hand passed? */
+	bool in_use;                /* Holds a sector at all? */
+	int pin_cnt;                /* Users that must not see it evicted. */
+	struct lock lock;           /* Protects VALID, DIRTY and DATA. */
+	uint8_t *data;              /* DISK_SECTOR_SIZE bytes. */
+	struct hash_elem elem;      /* Element in index. */
+};
+
+/* How often dirty sectors are written back, in timer ticks. */
+#define FLUSH_INTERVAL (5 * TIMER_FREQ)
+
+/* Maximum number of pending read-ahead requests. */
+#define READ_AHEAD_MAX 16
+
+size_t cache_size = CACHE_DEFAULT_SIZE;
+
+static struct cache_entry *entries;
+static struct hash index;       /* Entries in use, by sector. */
+static size_t hand;             /* Clock hand. */
+static struct lock cache_lock;
+
+/* Pending read-ahead sectors. */
+static disk_sector_t ahead[READ_AHEAD_MAX];
+static size_t ahead_head, ahead_tail;
+static struct lock ahead_lock;
+static struct semaphore ahead_sema;
+
+/* Statistics. */
+static long long hit_cnt, miss_cnt;
+
+static hash_hash_func entry_hash;
+static hash_less_func entry_less;
+static struct cache_entry *get_entry (disk_sector_t, bool whole);
+static struct cache_entry *choose_victim (void);
+static void put_entry (struct cache_entry *);
+static thread_func read_ahead_thread NO_RETURN;
+static thread_func flush_thread NO_RETURN;
+
+/* Allocates CACHE_SIZE sectors for the cache and starts its helper
+ * threads. */
+void
+cache_init (void) {
+	size_t page_cnt;
+	uint8_t *data;
+
+	if (cache_size < 8)
+		cache_size = 8;
+	page_cnt = DIV_ROUND_UP (cache_size * DISK_SECTOR_SIZE, PGSIZE);
+	data = palloc_get_multiple (PAL_ASSERT, page_cnt);
+	entries = calloc (cache_size, sizeof *entries);
+	if (entries == NULL)
+		PANIC ("buffer cache allocation failed");
+
+	for (size_t i = 0; i < cache_size; i++) {
+		lock_init (&entries[i].lock);
+		entries[i].data = data + i * DISK_SECTOR_SIZE;
+	}
+	hash_init (&index, entry_hash, entry_less, NULL);
+	lock_init (&cache_lock);
+	lock_init (&ahead_lock);
+	sema_init (&ahead_sema, 0);
+
+	thread_create ("read-ahead", PRI_DEFAULT, read_ahead_thread, NULL);
+	thread_create ("write-behind", PRI_DEFAULT, flush_thread, NULL);
+}
+
+/* Writes every dirty sector to disk. */
+void
+cache_done (void) {
+	cache_flush ();
+}
+
+/* Copies SIZE bytes starting at byte OFS of SECTOR into BUFFER. */
+void
+cache_read (disk_sector_t sector, void *buffer, size_t ofs, size_t size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+
+	e = get_entry (sector, false);
+	memcpy (buffer, e->data + ofs, size);
+	put_entry (e);
+}
+
+/* Copies SIZE bytes from BUFFER into SECTOR starting at byte OFS.
+ * The sector reaches the disk later. */
+void
+cache_write (disk_sector_t sector, const void *buffer, size_t ofs,
+		size_t size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs + size <= DISK_SECTOR_SIZE);
+
+	e = get_entry (sector, size == DISK_SECTOR_SIZE);
+	memcpy (e->data + ofs, buffer, size);
+	e->valid = true;
+	e->dirty = true;
+	put_entry (e);
+}
+
+/* Asks for SECTOR to be brought into the cache in the background.
+ * The request is dropped if too many are pending. */
+void
+cache_read_ahead (disk_sector_t sector) {
+	bool queued = false;
+
+	lock_acquire (&ahead_lock);
+	if (ahead_tail - ahead_head < READ_AHEAD_MAX) {
+		ahead[ahead_tail++ % READ_AHEAD_MAX] = sector;
+		queued = true;
+	}
+	lock_release (&ahead_lock);
+	if (queued)
+		sema_up (&ahead_sema);
+}
+
+/* Writes every dirty sector to disk. */
+void
+cache_flush (void) {
+	cache_flush_range (0, (disk_sector_t) -1);
+}
+
+/* Writes the dirty sectors among the CNT starting at START to
+ * disk. */
+void
+cache_flush_range (disk_sector_t start, size_t cnt) {
+	for (size_t i = 0; i < cache_size; i++) {
+		struct cache_entry *e = &entries[i];
+
+		lock_acquire (&cache_lock);
+		if (!e->in_use || e->sector < start || e->sector - start >= cnt) {
+			lock_release (&cache_lock);
+			continue;
+		}
+		e->pin_cnt++;
+		lock_release (&cache_lock);
+
+		lock_acquire (&e->lock);
+		if (e->dirty) {
+			disk_write (filesys_disk, e->sector, e->data);
+			e->dirty = false;
+		}
+		put_entry (e);
+	}
+}
+
+/* Prints buffer cache statistics. */
+void
+cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses\n", hit_cnt, miss_cnt);
+}
+
+/* Returns the entry for SECTOR, pinned and with its lock held, to be
+ * released with put_entry().  Its data is valid unless WHOLE, which
+ * promises that the caller overwrites the whole sector, so that it
+ * need not be read from disk. */
+static struct cache_entry *
+get_entry (disk_sector_t sector, bool whole) {
+	struct cache_entry key, *e;
+	struct hash_elem *he;
+
+	key.sector = sector;
+	for (;;) {
+		lock_acquire (&cache_lock);
+		he = hash_find (&index, &key.elem);
+		if (he != NULL) {
+			e = hash_entry (he, struct cache_entry, elem);
+			e->pin_cnt++;
+			hit_cnt++;
+			lock_release (&cache_lock);
+			lock_acquire (&e->lock);
+			break;
+		}
+
+		e = choose_victim ();
+		if (e == NULL) {
+			/* Everything is pinned.  Let the pinners finish. */
+			lock_release (&cache_lock);
+			thread_yield ();
+			continue;
+		}
+
+		/* An unpinned entry's lock is free. */
+		e->pin_cnt++;
+		lock_acquire (&e->lock);
+		if (e->in_use && e->dirty) {
+			/* Write the old contents back without holding CACHE_LOCK.
+			 * E stays indexed under its old sector meanwhile, so nobody
+			 * reads that sector from disk before it gets there. */
+			lock_release (&cache_lock);
+			disk_write (filesys_disk, e->sector, e->data);
+			e->dirty = false;
+			lock_acquire (&cache_lock);
+
+			/* If someone now wants the old sector, or brought in the
+			 * new one, leave E as it is and start over. */
+			if (e->pin_cnt > 1 || hash_find (&index, &key.elem) != NULL) {
+				lock_release (&e->lock);
+				e->pin_cnt--;
+				lock_release (&cache_lock);
+				continue;
+			}
+		}
+
+		miss_cnt++;
+		if (e->in_use)
+			hash_delete (&index, &e->elem);
+		e->sector = sector;
+		e->in_use = true;
+		e->valid = false;
+		e->dirty = false;
+		hash_insert (&index, &e->elem);
+		lock_release (&cache_lock);
+		break;
+	}
+
+	if (!e->valid && !whole) {
+		disk_read (filesys_disk, sector, e->data);
+		e->valid = true;
+	}
+	e->accessed = true;
+	return e;
+}
+
+/* Runs the clock hand round to an unpinned entry that has not been
+ * used since the hand last passed it, and returns it.  Returns a null
+ * pointer if every entry is pinned. */
+static struct cache_entry *
+choose_victim (void) {
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	for (size_t i = 0; i < 2 * cache_size; i++) {
+		struct cache_entry *e = &entries[hand];
+		hand = (hand + 1) % cache_size;
+		if (e->pin_cnt > 0)
+			continue;
+		if (e->accessed && e->in_use) {
+			e->accessed = false;
+			continue;
+		}
+		return e;
+	}
+	return NULL;
+}
+
+/* Releases E, obtained from get_entry(). */
+static void
+put_entry (struct cache_entry *e) {
+	lock_release (&e->lock);
+	lock_acquire (&cache_lock);
+	e->pin_cnt--;
+	lock_release (&cache_lock);
+}
+
+/* Returns true if SECTOR is in the cache. */
+static bool
+is_cached (disk_sector_t sector) {
+	struct cache_entry key;
+	bool cached;
+
+	key.sector = sector;
+	lock_acquire (&cache_lock);
+	cached = hash_find (&index, &key.elem) != NULL;
+	lock_release (&cache_lock);
+	return cached;
+}
+
+/* Brings requested sectors into the cache. */
+static void
+read_ahead_thread (void *aux UNUSED) {
+	for (;;) {
+		disk_sector_t sector;
+
+		sema_down (&ahead_sema);
+		lock_acquire (&ahead_lock);
+		sector = ahead[ahead_head++ % READ_AHEAD_MAX];
+		lock_release (&ahead_lock);
+
+		if (!is_cached (sector))
+			put_entry (get_entry (sector, false));
+	}
+}
+
+/* Writes file system metadata and dirty sectors back every
+ * FLUSH_INTERVAL. */
+static void
+flush_thread (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (FLUSH_INTERVAL);
+		filesys_sync ();
+	}
+}
+
+static uint64_t
+entry_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct cache_entry *ce = hash_entry (e, struct cache_entry, elem);
+	return hash_int (ce->sector);
+}
+
+static bool
+entry_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct cache_entry, elem)->sector
+		< hash_entry (b, struct cache_entry, elem)->sector;
+}
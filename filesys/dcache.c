@@ -0,0 +1,167 @@
+#include "filesys/dcache.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Directory entry cache.
+
+   Maps a (directory inode sector, name) pair to the sector of the
+   inode the name refers to, or to DCACHE_NEGATIVE if the directory
+   is known to have no such name.  The directory code consults it
+   before searching a directory and keeps it current as entries are
+   added and removed.  At most DCACHE_SIZE entries are kept; the
+   least recently used one makes way for a new one. */
+
+#define DCACHE_SIZE 256
+
+struct dentry {
+	disk_sector_t parent;       /* Directory inode sector. */
+	char name[NAME_MAX + 1];    /* Name within PARENT. */
+	disk_sector_t child;        /* Inode sector, or DCACHE_NEGATIVE. */
+	struct hash_elem elem;      /* Element in dentries. */
+	struct list_elem lru_elem;  /* Element in lru, most recent first. */
+};
+
+static struct hash dentries;
+static struct list lru;
+static size_t dentry_cnt;
+static struct lock dcache_lock;
+
+/* Statistics. */
+static long long hit_cnt, neg_hit_cnt, miss_cnt;
+
+static hash_hash_func dentry_hash;
+static hash_less_func dentry_less;
+
+/* Initializes the directory entry cache. */
+void
+dcache_init (void) {
+	hash_init (&dentries, dentry_hash, dentry_less, NULL);
+	list_init (&lru);
+	lock_init (&dcache_lock);
+}
+
+/* Returns the cached entry for NAME in PARENT, or a null pointer.
+ * The caller must hold dcache_lock. */
+static struct dentry *
+find (disk_sector_t parent, const char *name) {
+	struct dentry key;
+	struct hash_elem *e;
+
+	if (strlen (name) > NAME_MAX)
+		return NULL;
+	key.parent = parent;
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&dentries, &key.elem);
+	return e != NULL ? hash_entry (e, struct dentry, elem) : NULL;
+}
+
+/* Looks up NAME in directory PARENT.  If the answer is cached,
+ * stores the child's sector, or DCACHE_NEGATIVE if there is no such
+ * name, in *CHILD and returns true.  Otherwise returns false. */
+bool
+dcache_lookup (disk_sector_t parent, const char *name,
+		disk_sector_t *child) {
+	struct dentry *d;
+
+	lock_acquire (&dcache_lock);
+	d = find (parent, name);
+	if (d != NULL) {
+		list_remove (&d->lru_elem);
+		list_push_front (&lru, &d->lru_elem);
+		*child = d->child;
+		if (d->child == DCACHE_NEGATIVE)
+			neg_hit_cnt++;
+		else
+			hit_cnt++;
+	} else
+		miss_cnt++;
+	lock_release (&dcache_lock);
+	return d != NULL;
+}
+
+/* Records that NAME in directory PARENT refers to CHILD, which may
+ * be DCACHE_NEGATIVE. */
+void
+dcache_insert (disk_sector_t parent, const char *name,
+		disk_sector_t child) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dcache_lock);
+	d = find (parent, name);
+	if (d != NULL)
+		list_remove (&d->lru_elem);
+	else {
+		if (dentry_cnt == DCACHE_SIZE) {
+			/* Recycle the least recently used entry. */
+			d = list_entry (list_pop_back (&lru), struct dentry, lru_elem);
+			hash_delete (&dentries, &d->elem);
+		} else {
+			d = malloc (sizeof *d);
+			if (d == NULL) {
+				lock_release (&dcache_lock);
+				return;
+			}
+			dentry_cnt++;
+		}
+		d->parent = parent;
+		strlcpy (d->name, name, sizeof d->name);
+		hash_insert (&dentries, &d->elem);
+	}
+	d->child = child;
+	list_push_front (&lru, &d->lru_elem);
+	lock_release (&dcache_lock);
+}
+
+/* Forgets whatever is cached for NAME in directory PARENT. */
+void
+dcache_invalidate (disk_sector_t parent, const char *name) {
+	struct dentry *d;
+
+	lock_acquire (&dcache_lock);
+	d = find (parent, name);
+	if (d != NULL) {
+		hash_delete (&dentries, &d->elem);
+		list_remove (&d->lru_elem);
+		dentry_cnt--;
+		free (d);
+	}
+	lock_release (&dcache_lock);
+}
+
+/* Prints directory entry cache statistics. */
+void
+dcache_print_stats (void) {
+	long long total = hit_cnt + neg_hit_cnt + miss_cnt;
+
+	printf ("Dentry cache: %lld hits (%lld negative), %lld misses",
+			hit_cnt + neg_hit_cnt, neg_hit_cnt, miss_cnt);
+	if (total > 0)
+		printf (", %lld%% hit rate", (hit_cnt + neg_hit_cnt) * 100 / total);
+	printf ("\n");
+}
+
+static uint64_t
+dentry_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct dentry *d = hash_entry (e, struct dentry, elem);
+	return hash_string (d->name) ^ hash_int (d->parent);
+}
+
+static bool
+dentry_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct dentry *a = hash_entry (a_, struct dentry, elem);
+	const struct dentry *b = hash_entry (b_, struct dentry, elem);
+
+	if (a->parent != b->parent)
+		return a->parent < b->parent;
+	return strcmp (a->name, b->name) < 0;
+}
@@ -1,10 +1,13 @@
 #include "filesys/directory.h"
 #include <stdio.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
+#include "filesys/dcache.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -19,6 +22,42 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* Directories come in two formats.  A linear directory is an array
+ * of entries, searched from the start.  Once a linear directory holds
+ * DIR_HASH_THRESHOLD entries it is converted to a hashed directory:
+ * a header followed by SLOT_CNT entry slots, where an entry lives in
+ * the first free slot at or after the hash of its name (linear
+ * probing).  Slots of a hashed directory are empty (zero name),
+ * deleted (nonempty name but not in use) or in use.  The header and
+ * every unused slot have IN_USE false, so code that reads a hashed
+ * directory as a linear one, such as dir_readdir(), still sees
+ * exactly the entries in use. */
+#define DIR_HASH_MAGIC 0x48545245       /* "HTRE", not a valid sector. */
+#define DIR_HASH_THRESHOLD 32           /* Entries that trigger hashing. */
+#define DIR_HASH_MIN_SLOTS 64           /* Smallest hashed directory. */
+
+/* First entry of a hashed directory.  Same size as a dir_entry, with
+ * MAGIC where an entry's INODE_SECTOR would be. */
+struct dir_header {
+	uint32_t magic;                     /* DIR_HASH_MAGIC. */
+	uint32_t slot_cnt;                  /* Slots after the header. */
+	uint32_t used_cnt;                  /* Slots in use. */
+	uint32_t dead_cnt;                  /* Slots deleted. */
+	uint8_t pad[3];                     /* Unused. */
+	bool in_use;                        /* Always false. */
+};
+
+/* Serializes lookups and updates of directory entries, so that a
+ * name cannot be added twice or removed while it is being opened. */
+static struct lock dir_lock;
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	ASSERT (sizeof (struct dir_header) == sizeof (struct dir_entry));
+	lock_init (&dir_lock);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -71,32 +110,167 @@ dir_get_inode (struct dir *dir) {
 	return dir->inode;
 }
 
+/* Returns the byte offset of hashed directory slot I. */
+static inline off_t
+slot_ofs (size_t i) {
+	return (i + 1) * sizeof (struct dir_entry);
+}
+
+/* Reads DIR's header into *H and returns true if DIR is hashed.
+ * Returns false if DIR is linear. */
+static bool
+read_header (const struct dir *dir, struct dir_header *h) {
+	return inode_read_at (dir->inode, h, sizeof *h, 0) == sizeof *h
+		&& h->magic == DIR_HASH_MAGIC && !h->in_use;
+}
+
+/* Writes header H of hashed directory DIR. */
+static bool
+write_header (struct dir *dir, const struct dir_header *h) {
+	return inode_write_at (dir->inode, h, sizeof *h, 0) == sizeof *h;
+}
+
+/* Returns the slot where the probe for NAME starts in a hashed
+ * directory with header H. */
+static size_t
+home_slot (const struct dir_header *h, const char *name) {
+	return hash_string (name) % h->slot_cnt;
+}
+
 /* Searches DIR for a file with the given NAME.
  * If successful, returns true, sets *EP to the directory entry
  * if EP is non-null, and sets *OFSP to the byte offset of the
  * directory entry if OFSP is non-null.
- * otherwise, returns false and ignores EP and OFSP. */
+ * otherwise, returns false and ignores EP and OFSP.
+ * A hashed directory is probed from NAME's home slot up to the
+ * first empty slot, so the expected cost does not depend on the
+ * directory's size. */
 static bool
 lookup (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
+	struct dir_header h;
 	struct dir_entry e;
 	size_t ofs;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	if (read_header (dir, &h)) {
+		size_t i = home_slot (&h, name);
+
+		for (size_t n = 0; n < h.slot_cnt; n++, i = (i + 1) % h.slot_cnt) {
+			ofs = slot_ofs (i);
+			if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e
+					|| (!e.in_use && e.name[0] == '\0'))
+				break;
+			if (e.in_use && !strcmp (name, e.name))
+				goto found;
+		}
+		return false;
+	}
+
 	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
-		if (e.in_use && !strcmp (name, e.name)) {
-			if (ep != NULL)
-				*ep = e;
-			if (ofsp != NULL)
-				*ofsp = ofs;
-			return true;
+		if (e.in_use && !strcmp (name, e.name))
+			goto found;
+	return false;
+
+found:
+	if (ep != NULL)
+		*ep = e;
+	if (ofsp != NULL)
+		*ofsp = ofs;
+	return true;
+}
+
+/* Puts entry E in the first free slot of its probe sequence in
+ * hashed directory DIR, whose header is *H, and updates *H in memory
+ * only.  Returns true if successful. */
+static bool
+slot_insert (struct dir *dir, struct dir_header *h,
+		const struct dir_entry *e) {
+	struct dir_entry slot;
+	size_t i = home_slot (h, e->name);
+
+	for (size_t n = 0; n < h->slot_cnt; n++, i = (i + 1) % h->slot_cnt) {
+		if (inode_read_at (dir->inode, &slot, sizeof slot, slot_ofs (i))
+				!= sizeof slot)
+			return false;
+		if (!slot.in_use) {
+			if (slot.name[0] != '\0')
+				h->dead_cnt--;
+			h->used_cnt++;
+			return inode_write_at (dir->inode, e, sizeof *e, slot_ofs (i))
+				== sizeof *e;
 		}
+	}
 	return false;
 }
 
+/* Rewrites DIR as a hashed directory of at least SLOT_CNT slots
+ * holding the same entries, with no deleted slots, growing it as
+ * needed.  Works for linear and hashed directories alike.  Returns
+ * true if successful.  DIR is grown before anything in it is
+ * overwritten, so running out of disk space leaves it unchanged. */
+static bool
+rehash (struct dir *dir, size_t slot_cnt) {
+	static const char zeros[DISK_SECTOR_SIZE];
+	struct dir_entry *entries, e;
+	struct dir_header h;
+	size_t cnt = 0, cap = 16;
+	off_t ofs, length, old_length = inode_length (dir->inode);
+	bool success = true;
+
+	/* Gather the entries in use. */
+	entries = malloc (cap * sizeof *entries);
+	if (entries == NULL)
+		return false;
+	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+			ofs += sizeof e) {
+		if (!e.in_use)
+			continue;
+		if (cnt == cap) {
+			struct dir_entry *bigger = realloc (entries,
+					2 * cap * sizeof *entries);
+			if (bigger == NULL) {
+				free (entries);
+				return false;
+			}
+			entries = bigger;
+			cap *= 2;
+		}
+		entries[cnt++] = e;
+	}
+
+	/* Cover the whole old file, so no stale entry survives past the
+	 * new slots, and keep the load factor at most 1/2. */
+	while (slot_ofs (slot_cnt) < old_length || 2 * (cnt + 1) > slot_cnt)
+		slot_cnt *= 2;
+
+	/* Grow to the new length first; the space added reads as zeros. */
+	length = slot_ofs (slot_cnt);
+	if (length > old_length) {
+		off_t n = length - old_length < (off_t) sizeof zeros
+			? length - old_length : (off_t) sizeof zeros;
+		success = inode_write_at (dir->inode, zeros, n, length - n) == n;
+	}
+
+	/* Clear the old contents and lay the entries out anew. */
+	for (ofs = 0; ofs < old_length && success; ofs += sizeof zeros) {
+		off_t n = old_length - ofs < (off_t) sizeof zeros
+			? old_length - ofs : (off_t) sizeof zeros;
+		success = inode_write_at (dir->inode, zeros, n, ofs) == n;
+	}
+	memset (&h, 0, sizeof h);
+	h.magic = DIR_HASH_MAGIC;
+	h.slot_cnt = slot_cnt;
+	for (size_t i = 0; i < cnt && success; i++)
+		success = slot_insert (dir, &h, &entries[i]);
+	success = success && write_header (dir, &h);
+	free (entries);
+	return success;
+}
+
 /* Searches DIR for a file with the given NAME
  * and returns true if one exists, false otherwise.
  * On success, sets *INODE to an inode for the file, otherwise to
@@ -109,10 +283,18 @@ dir_lookup (const struct dir *dir, const char *name,
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	if (lookup (dir, name, &e, NULL))
+	lock_acquire (&dir_lock);
+	if (!dcache_lookup (inode_get_inumber (dir->inode), name,
+				&e.inode_sector)) {
+		if (!lookup (dir, name, &e, NULL))
+			e.inode_sector = DCACHE_NEGATIVE;
+		dcache_insert (inode_get_inumber (dir->inode), name, e.inode_sector);
+	}
+	if (e.inode_sector != DCACHE_NEGATIVE)
 		*inode = inode_open (e.inode_sector);
 	else
 		*inode = NULL;
+	lock_release (&dir_lock);
 
 	return *inode != NULL;
 }
@@ -125,8 +307,11 @@ dir_lookup (const struct dir *dir, const char *name,
  * error occurs. */
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
-	struct dir_entry e;
-	off_t ofs;
+	struct dir_entry e, slot;
+	struct dir_header h;
+	disk_sector_t sector;
+	off_t ofs, pos;
+	size_t used_cnt = 0;
 	bool success = false;
 
 	ASSERT (dir != NULL);
@@ -137,28 +322,59 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 		return false;
 
 	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
+	lock_acquire (&dir_lock);
+	if (dcache_lookup (inode_get_inumber (dir->inode), name, &sector)) {
+		if (sector != DCACHE_NEGATIVE)
+			goto done;
+	} else if (lookup (dir, name, NULL, NULL))
 		goto done;
 
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
-			break;
-
-	/* Write slot. */
 	e.in_use = true;
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
-	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+
+	if (!read_header (dir, &h)) {
+		/* Set OFS to offset of free slot.
+		 * If there are no free slots, then it will be set to the
+		 * current end-of-file.
+
+		 * inode_read_at() will only return a short read at end of file.
+		 * Otherwise, we'd need to verify that we didn't get a short
+		 * read due to something intermittent such as low memory. */
+		ofs = -1;
+		for (pos = 0; inode_read_at (dir->inode, &slot, sizeof slot, pos)
+				== sizeof slot; pos += sizeof slot)
+			if (slot.in_use)
+				used_cnt++;
+			else if (ofs == -1)
+				ofs = pos;
+		if (ofs == -1)
+			ofs = pos;
+
+		if (used_cnt + 1 < DIR_HASH_THRESHOLD) {
+			success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+			if (success)
+				dcache_insert (inode_get_inumber (dir->inode), name, inode_sector);
+			goto done;
+		}
+
+		/* Switch to hashing once the directory is big enough for
+		 * linear search to hurt. */
+		if (!rehash (dir, DIR_HASH_MIN_SLOTS) || !read_header (dir, &h))
+			goto done;
+	} else if (4 * (h.used_cnt + h.dead_cnt + 1) > 3 * h.slot_cnt) {
+		/* Keep at least a quarter of the slots empty, so that probes
+		 * stay short and always end. */
+		if (!rehash (dir, h.slot_cnt) || !read_header (dir, &h))
+			goto done;
+	}
+
+	success = slot_insert (dir, &h, &e) && write_header (dir, &h);
+	if (success)
+		dcache_insert (inode_get_inumber (dir->inode), name, inode_sector);
 
 done:
+	lock_release (&dir_lock);
 	return success;
 }
 
@@ -168,6 +384,7 @@ done:
 bool
 dir_remove (struct dir *dir, const char *name) {
 	struct dir_entry e;
+	struct dir_header h;
 	struct inode *inode = NULL;
 	bool success = false;
 	off_t ofs;
@@ -176,6 +393,7 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (name != NULL);
 
 	/* Find directory entry. */
+	lock_acquire (&dir_lock);
 	if (!lookup (dir, name, &e, &ofs))
 		goto done;
 
@@ -184,16 +402,24 @@ dir_remove (struct dir *dir, const char *name) {
 	if (inode == NULL)
 		goto done;
 
-	/* Erase directory entry. */
+	/* Erase directory entry.  Its name stays, so that in a hashed
+	 * directory it marks a deleted slot rather than an empty one. */
 	e.in_use = false;
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
+	dcache_invalidate (inode_get_inumber (dir->inode), name);
+	if (read_header (dir, &h)) {
+		h.used_cnt--;
+		h.dead_cnt++;
+		write_header (dir, &h);
+	}
 
 	/* Remove inode. */
 	inode_remove (inode);
 	success = true;
 
 done:
+	lock_release (&dir_lock);
 	inode_close (inode);
 	return success;
 }
@@ -204,13 +430,17 @@ done:
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
+	bool success = false;
 
+	lock_acquire (&dir_lock);
 	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
-			return true;
+			success = true;
+			break;
 		}
 	}
-	return false;
+	lock_release (&dir_lock);
+	return success;
 }
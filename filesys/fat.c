@@ -1,4 +1,5 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
@@ -22,14 +23,22 @@ struct fat_fs {
 	unsigned int *fat;
 	unsigned int fat_length;
 	disk_sector_t data_start;
-	cluster_t last_clst;
-	struct lock write_lock;
+	cluster_t last_clst;        /* Where the next allocation search starts. */
+	struct bitmap *used;        /* One bit per cluster, set if in use. */
+	size_t free_cnt;            /* Number of clear bits in USED. */
+	struct bitmap *dirty;       /* One bit per FAT sector, set if changed. */
+	bool bs_dirty;              /* Boot sector changed? */
+	struct lock write_lock;     /* Protects FAT, USED, FREE_CNT and
+	                               LAST_CLST. */
 };
 
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_build_used (void);
+static void fat_set (cluster_t, cluster_t);
+static void fat_write_sector (unsigned int);
 
 void
 fat_init (void) {
@@ -53,6 +62,8 @@ fat_init (void) {
 
 void
 fat_open (void) {
+	/* A format boot has built these already, in fat_create(). */
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
@@ -78,39 +89,59 @@ fat_open (void) {
 			free (bounce);
 		}
 	}
+	fat_build_used ();
 }
 
+/* Writes FAT sector I, counting from the start of the FAT, to
+ * disk. */
+static void
+fat_write_sector (unsigned int i) {
+	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
+	uint8_t *buffer = (uint8_t *) fat_fs->fat + i * DISK_SECTOR_SIZE;
+	off_t bytes_left = fat_size_in_bytes - (off_t) i * DISK_SECTOR_SIZE;
+
+	if (bytes_left >= DISK_SECTOR_SIZE)
+		disk_write (filesys_disk, fat_fs->bs.fat_start + i, buffer);
+	else {
+		uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
+		if (bounce == NULL)
+			PANIC ("FAT write failed");
+		if (bytes_left > 0)
+			memcpy (bounce, buffer, bytes_left);
+		disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
+		free (bounce);
+	}
+}
+
+/* Writes the FAT sectors changed since the last call to disk, in
+ * order, and the boot sector if it changed. */
 void
-fat_close (void) {
-	// Write FAT boot sector
-	uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
-	if (bounce == NULL)
-		PANIC ("FAT close failed");
-	memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
-	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
-	free (bounce);
+fat_sync (void) {
+	size_t i = 0;
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return;
+
+	lock_acquire (&fat_fs->write_lock);
+	if (fat_fs->bs_dirty) {
+		uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
+		if (bounce == NULL)
+			PANIC ("FAT write failed");
+		memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
+		disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
+		free (bounce);
+		fat_fs->bs_dirty = false;
+	}
+	while ((i = bitmap_scan (fat_fs->dirty, i, 1, true)) != BITMAP_ERROR) {
+		fat_write_sector (i);
+		bitmap_reset (fat_fs->dirty, i);
 	}
+	lock_release (&fat_fs->write_lock);
+}
+
+void
+fat_close (void) {
+	fat_sync ();
 }
 
 void
@@ -123,6 +154,8 @@ fat_create (void) {
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_build_used ();
+	bitmap_set_all (fat_fs->dirty, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -140,6 +173,7 @@ fat_boot_create (void) {
 	unsigned int fat_sectors =
 	    (disk_size (filesys_disk) - 1)
 	    / (DISK_SECTOR_SIZE / sizeof (cluster_t) * SECTORS_PER_CLUSTER + 1) + 1;
+	fat_fs->bs_dirty = true;
 	fat_fs->bs = (struct fat_boot){
 	    .magic = FAT_MAGIC,
 	    .sectors_per_cluster = SECTORS_PER_CLUSTER,
@@ -152,42 +186,158 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	unsigned int data_sectors;
+
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	data_sectors = fat_fs->bs.total_sectors - fat_fs->data_start;
+
+	/* Entry 0 is unused, since 0 marks a free cluster. */
+	fat_fs->fat_length = data_sectors / SECTORS_PER_CLUSTER + 1;
+	if (fat_fs->fat_length
+			> fat_fs->bs.fat_sectors * (DISK_SECTOR_SIZE / sizeof (cluster_t)))
+		fat_fs->fat_length =
+			fat_fs->bs.fat_sectors * (DISK_SECTOR_SIZE / sizeof (cluster_t));
+	fat_fs->last_clst = ROOT_DIR_CLUSTER + 1;
+	lock_init (&fat_fs->write_lock);
+}
+
+/* Derives the in-use cluster bitmap from the FAT, so that
+ * allocation never has to scan the FAT itself. */
+static void
+fat_build_used (void) {
+	bitmap_destroy (fat_fs->used);
+	bitmap_destroy (fat_fs->dirty);
+	fat_fs->used = bitmap_create (fat_fs->fat_length);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->used == NULL || fat_fs->dirty == NULL)
+		PANIC ("FAT bitmap creation failed");
+	bitmap_mark (fat_fs->used, 0);
+	fat_fs->free_cnt = 0;
+	for (cluster_t c = 1; c < fat_fs->fat_length; c++)
+		if (fat_fs->fat[c] != 0)
+			bitmap_mark (fat_fs->used, c);
+		else
+			fat_fs->free_cnt++;
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Finds CNT free clusters in a row, searching from the next-fit hint
+ * and wrapping round to the start.  Returns the first, or 0 if there
+ * is no such run. */
+static cluster_t
+find_run (size_t cnt) {
+	size_t c = bitmap_scan (fat_fs->used, fat_fs->last_clst, cnt, false);
+	if (c == BITMAP_ERROR)
+		c = bitmap_scan (fat_fs->used, 1, cnt, false);
+	return c == BITMAP_ERROR ? 0 : c;
+}
+
+/* Appends CNT newly allocated clusters to the chain that ends at
+ * CLST, or starts a new chain if CLST is 0.  The clusters go right
+ * after CLST if they are free, else in the first run of CNT free
+ * clusters at or after the next-fit hint, else wherever single free
+ * clusters are found.  Returns the first new cluster, or 0 if the
+ * disk is full, in which case nothing is allocated.
+ * Nothing calls this yet: inodes take their sectors from the free
+ * map, even in the EFILESYS build. */
+cluster_t
+fat_create_chain_n (cluster_t clst, size_t cnt) {
+	cluster_t first = 0, prev = clst;
+
+	ASSERT (cnt > 0);
+
+	lock_acquire (&fat_fs->write_lock);
+	if (fat_fs->free_cnt < cnt) {
+		lock_release (&fat_fs->write_lock);
+		return 0;
+	}
+
+	while (cnt > 0) {
+		cluster_t c;
+		size_t run = cnt;
+
+		if (prev != 0 && prev + 1 + run <= fat_fs->fat_length
+				&& bitmap_none (fat_fs->used, prev + 1, run))
+			c = prev + 1;
+		else
+			while ((c = find_run (run)) == 0)
+				run /= 2;
+
+		for (size_t i = 0; i < run; i++) {
+			fat_set (c + i, EOChain);
+			if (prev != 0)
+				fat_set (prev, c + i);
+			prev = c + i;
+		}
+		if (first == 0)
+			first = c;
+		fat_fs->last_clst = (c + run) % fat_fs->fat_length;
+		cnt -= run;
+	}
+	lock_release (&fat_fs->write_lock);
+	return first;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	return fat_create_chain_n (clst, 1);
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_get (clst);
+		fat_set (clst, 0);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	fat_set (clst, val);
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Sets FAT entry CLST to VAL, keeping USED, FREE_CNT and DIRTY in
+ * step.  The caller must hold the FAT write lock. */
+static void
+fat_set (cluster_t clst, cluster_t val) {
+	ASSERT (lock_held_by_current_thread (&fat_fs->write_lock));
+	ASSERT (clst > 0 && clst < fat_fs->fat_length);
+	if (fat_fs->fat[clst] == 0 && val != 0)
+		fat_fs->free_cnt--;
+	else if (fat_fs->fat[clst] != 0 && val == 0)
+		fat_fs->free_cnt++;
+	fat_fs->fat[clst] = val;
+	bitmap_set (fat_fs->used, clst, val != 0);
+	bitmap_mark (fat_fs->dirty,
+			clst / (DISK_SECTOR_SIZE / sizeof (cluster_t)));
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst > 0 && clst < fat_fs->fat_length);
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst > 0);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
 }
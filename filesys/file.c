@@ -1,13 +1,20 @@
 #include "filesys/file.h"
 #include <debug.h>
 #include "filesys/inode.h"
+#include "filesys/pipe.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
 
-/* An open file. */
+/* An open file: either an open inode, or one end of a pipe, in which
+ * case INODE is null. */
 struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	int ref_cnt;                /* Descriptors sharing this open file. */
+	struct pipe *pipe;          /* Pipe, if this is a pipe end. */
+	bool pipe_writer;           /* Write end rather than read end? */
 };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -20,6 +27,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -28,6 +36,38 @@ file_open (struct inode *inode) {
 	}
 }
 
+/* Creates a pipe and stores files for its read and write ends in
+ * *READ_END and *WRITE_END.  Returns false if memory is exhausted. */
+bool
+file_open_pipe (struct file **read_end, struct file **write_end) {
+	struct pipe *pipe = pipe_create ();
+	struct file *r, *w;
+
+	if (pipe == NULL)
+		return false;
+	r = calloc (1, sizeof *r);
+	w = calloc (1, sizeof *w);
+	if (r == NULL || w == NULL) {
+		free (r);
+		free (w);
+		pipe_close_end (pipe, false);
+		pipe_close_end (pipe, true);
+		return false;
+	}
+	r->ref_cnt = w->ref_cnt = 1;
+	r->pipe = w->pipe = pipe;
+	w->pipe_writer = true;
+	*read_end = r;
+	*write_end = w;
+	return true;
+}
+
+/* Returns true if FILE is one end of a pipe. */
+bool
+file_is_pipe (struct file *file) {
+	return file->pipe != NULL;
+}
+
 /* Opens and returns a new file for the same inode as FILE.
  * Returns a null pointer if unsuccessful. */
 struct file *
@@ -39,7 +79,19 @@ file_reopen (struct file *file) {
  * same inode as FILE. Returns a null pointer if unsuccessful. */
 struct file *
 file_duplicate (struct file *file) {
-	struct file *nfile = file_open (inode_reopen (file->inode));
+	struct file *nfile;
+
+	if (file->pipe != NULL) {
+		nfile = calloc (1, sizeof *nfile);
+		if (nfile != NULL) {
+			*nfile = *file;
+			nfile->ref_cnt = 1;
+			pipe_open_end (file->pipe, file->pipe_writer);
+		}
+		return nfile;
+	}
+
+	nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
 		if (file->deny_write)
@@ -48,10 +100,34 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
-/* Closes FILE. */
+/* Returns another reference to FILE itself, sharing its position, as
+ * dup2() does.  Each reference is released with file_close(). */
+struct file *
+file_dup (struct file *file) {
+	ASSERT (file != NULL);
+	file->ref_cnt++;
+	return file;
+}
+
+/* Returns true if more than one reference to FILE is open. */
+bool
+file_is_shared (struct file *file) {
+	ASSERT (file != NULL);
+	return file->ref_cnt > 1;
+}
+
+/* Closes FILE.  The file is only released once every reference
+ * obtained through file_dup() has been closed. */
 void
 file_close (struct file *file) {
 	if (file != NULL) {
+		if (--file->ref_cnt > 0)
+			return;
+		if (file->pipe != NULL) {
+			pipe_close_end (file->pipe, file->pipe_writer);
+			free (file);
+			return;
+		}
 		file_allow_write (file);
 		inode_close (file->inode);
 		free (file);
@@ -71,6 +147,11 @@ file_get_inode (struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
+	if (file->pipe != NULL) {
+		struct iovec iov = { buffer, size };
+		return file_readv (file, &iov, 1);
+	}
+
 	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
 	return bytes_read;
@@ -80,9 +161,12 @@ file_read (struct file *file, void *buffer, off_t size) {
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually read,
  * which may be less than SIZE if end of file is reached.
- * The file's current position is unaffected. */
+ * The file's current position is unaffected.
+ * Pipes have no offsets, so this fails with -1 on a pipe. */
 off_t
 file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
+	if (file->pipe != NULL)
+		return -1;
 	return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
@@ -95,6 +179,11 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
+	if (file->pipe != NULL) {
+		struct iovec iov = { (void *) buffer, size };
+		return file_writev (file, &iov, 1);
+	}
+
 	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
@@ -106,19 +195,93 @@ file_write (struct file *file, const void *buffer, off_t size) {
  * which may be less than SIZE if end of file is reached.
  * (Normally we'd grow the file in that case, but file growth is
  * not yet implemented.)
- * The file's current position is unaffected. */
+ * The file's current position is unaffected.
+ * Pipes have no offsets, so this fails with -1 on a pipe. */
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
 		off_t file_ofs) {
+	if (file->pipe != NULL)
+		return -1;
 	return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Copies up to SIZE bytes from IN, starting at IN_OFS, to OUT,
+ * starting at OUT_OFS, without touching either file's position.
+ * Data moves a page at a time through a page-aligned kernel buffer,
+ * so sector-aligned ranges go straight between the disk and the
+ * buffer in runs of whole sectors.  Stops early at end of IN or when
+ * OUT cannot take more.  Returns the number of bytes copied, or -1 if
+ * no buffer could be allocated. */
+off_t
+file_copy_range (struct file *in, off_t in_ofs, struct file *out,
+		off_t out_ofs, off_t size) {
+	uint8_t *buf;
+	off_t copied = 0;
+
+	ASSERT (in != NULL);
+	ASSERT (out != NULL);
+
+	if (in->pipe != NULL || out->pipe != NULL)
+		return -1;
+	buf = palloc_get_page (0);
+	if (buf == NULL)
+		return -1;
+	while (size > 0) {
+		off_t chunk = size < PGSIZE ? size : PGSIZE;
+		off_t bytes_read, bytes_written;
+
+		bytes_read = inode_read_at (in->inode, buf, chunk, in_ofs + copied);
+		if (bytes_read <= 0)
+			break;
+		bytes_written = inode_write_at (out->inode, buf, bytes_read,
+				out_ofs + copied);
+		copied += bytes_written;
+		size -= bytes_written;
+		if (bytes_written < bytes_read)
+			break;
+	}
+	palloc_free_page (buf);
+	return copied;
+}
+
+/* Reads from FILE into the IOV_CNT buffers of IOV, in order,
+ * starting at the file's current position.
+ * Returns the number of bytes actually read,
+ * which may be less than requested if end of file is reached.
+ * Advances FILE's position by the number of bytes read.
+ * On the read end of a pipe, behaves like pipe_readv(). */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int iov_cnt) {
+	if (file->pipe != NULL)
+		return file->pipe_writer ? -1 : pipe_readv (file->pipe, iov, iov_cnt);
+
+	off_t bytes_read = inode_readv (file->inode, iov, iov_cnt, file->pos);
+	file->pos += bytes_read;
+	return bytes_read;
+}
+
+/* Writes the IOV_CNT buffers of IOV, in order, into FILE,
+ * starting at the file's current position.
+ * Returns the number of bytes actually written,
+ * which may be less than requested if end of file is reached.
+ * Advances FILE's position by the number of bytes written.
+ * On the write end of a pipe, behaves like pipe_writev(). */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int iov_cnt) {
+	if (file->pipe != NULL)
+		return file->pipe_writer ? pipe_writev (file->pipe, iov, iov_cnt) : -1;
+
+	off_t bytes_written = inode_writev (file->inode, iov, iov_cnt, file->pos);
+	file->pos += bytes_written;
+	return bytes_written;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void
 file_deny_write (struct file *file) {
 	ASSERT (file != NULL);
-	if (!file->deny_write) {
+	if (file->pipe == NULL && !file->deny_write) {
 		file->deny_write = true;
 		inode_deny_write (file->inode);
 	}
@@ -136,10 +299,12 @@ file_allow_write (struct file *file) {
 	}
 }
 
-/* Returns the size of FILE in bytes. */
+/* Returns the size of FILE in bytes, or -1 if FILE is a pipe. */
 off_t
 file_length (struct file *file) {
 	ASSERT (file != NULL);
+	if (file->pipe != NULL)
+		return -1;
 	return inode_length (file->inode);
 }
 
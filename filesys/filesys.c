@@ -2,6 +2,9 @@
 #include <debug.h>
 #include <stdio.h>
 #include <string.h>
+#include "filesys/cache.h"
+#include "filesys/dcache.h"
+#include "filesys/fat.h"
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
@@ -22,6 +25,9 @@ filesys_init (bool format) {
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init ();
+	cache_init ();
+	dir_init ();
+	dcache_init ();
 
 #ifdef EFILESYS
 	fat_init ();
@@ -41,6 +47,18 @@ filesys_init (bool format) {
 #endif
 }
 
+/* Writes changed file system metadata, then every dirty cached
+ * sector, to disk. */
+void
+filesys_sync (void) {
+#ifdef EFILESYS
+	fat_sync ();
+#else
+	free_map_sync ();
+#endif
+	cache_flush ();
+}
+
 /* Shuts down the file system module, writing any unwritten data
  * to disk. */
 void
@@ -51,6 +69,7 @@ filesys_done (void) {
 #else
 	free_map_close ();
 #endif
+	cache_done ();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -62,7 +81,8 @@ filesys_create (const char *name, off_t initial_size) {
 	disk_sector_t inode_sector = 0;
 	struct dir *dir = dir_open_root ();
 	bool success = (dir != NULL
-			&& free_map_allocate (1, &inode_sector)
+			&& free_map_allocate_near (1,
+				inode_get_inumber (dir_get_inode (dir)), &inode_sector)
 			&& inode_create (inode_sector, initial_size)
 			&& dir_add (dir, name, inode_sector));
 	if (!success && inode_sector != 0)
@@ -1,47 +1,421 @@
 #include "filesys/free-map.h"
 #include <bitmap.h>
 #include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <round.h>
+#include <stdio.h>
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
+static struct lock free_map_lock;    /* Protects the free map. */
+
+/* Besides the bitmap, which is what goes to disk, the free sectors
+ * are kept as a set of maximal free extents, indexed two ways.  A
+ * treap ordered by first sector finds the extents on either side of
+ * any sector in O(log n), so a released run merges with its
+ * neighbours and a locality goal finds the next free run without
+ * looking at the bitmap.  Lists by size class (floor of log2 of the
+ * length) let best fit look at few extents.  Requests of up to
+ * SMALL_ALLOC sectors with a goal take the first free run at or
+ * after it, so that a directory's small files sit together. */
+struct free_extent {
+	disk_sector_t start;                /* First free sector. */
+	size_t cnt;                         /* Number of free sectors. */
+	uint64_t prio;                      /* Treap priority. */
+	struct free_extent *left, *right;   /* Children in BY_POS. */
+	struct list_elem size_elem;         /* Element in size_class[]. */
+};
+
+#define SIZE_CLASSES 32
+#define SMALL_ALLOC 8
+
+/* Extents after a locality goal that free_map_allocate_near() tries
+ * before falling back to best fit. */
+#define NEAR_TRIES 8
+
+static struct free_extent *by_pos;  /* Treap root. */
+static struct list size_class[SIZE_CLASSES];
+static struct slab_cache extent_cache;
+
+static void build_extents (void);
+
+/* One bit per sector of the free map file, set if that part of
+ * FREE_MAP has changed since it was last written to the file. */
+static struct bitmap *free_map_dirty;
+
+/* Notes that the bits for CNT sectors starting at SECTOR changed. */
+static void
+mark_dirty (disk_sector_t sector, size_t cnt) {
+	size_t bits_per_sector = DISK_SECTOR_SIZE * 8;
+	size_t first = sector / bits_per_sector;
+	size_t last = (sector + cnt - 1) / bits_per_sector;
+
+	bitmap_set_multiple (free_map_dirty, first, last - first + 1, true);
+}
+
+/* Returns the size class of a CNT-sector extent. */
+static size_t
+class_of (size_t cnt) {
+	size_t k = 63 - __builtin_clzll (cnt);
+	return k < SIZE_CLASSES ? k : SIZE_CLASSES - 1;
+}
+
+/* Splits treap T into the extents that start before SECTOR, stored
+ * in *L, and the rest, stored in *R. */
+static void
+split (struct free_extent *t, disk_sector_t sector,
+		struct free_extent **l, struct free_extent **r) {
+	if (t == NULL)
+		*l = *r = NULL;
+	else if (t->start < sector) {
+		split (t->right, sector, &t->right, r);
+		*l = t;
+	} else {
+		split (t->left, sector, l, &t->left);
+		*r = t;
+	}
+}
+
+/* Joins treaps A and B, where every extent in A comes before every
+ * extent in B, and returns the result. */
+static struct free_extent *
+merge (struct free_extent *a, struct free_extent *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (a->prio > b->prio) {
+		a->right = merge (a->right, b);
+		return a;
+	}
+	b->left = merge (a, b->left);
+	return b;
+}
+
+/* Adds E to the extent indexes. */
+static void
+extent_add (struct free_extent *e) {
+	struct free_extent **t = &by_pos;
+
+	e->prio = hash_int (e->start);
+	while (*t != NULL && (*t)->prio >= e->prio)
+		t = e->start < (*t)->start ? &(*t)->left : &(*t)->right;
+	split (*t, e->start, &e->left, &e->right);
+	*t = e;
+	list_push_front (&size_class[class_of (e->cnt)], &e->size_elem);
+}
+
+/* Removes E from the extent indexes. */
+static void
+extent_del (struct free_extent *e) {
+	struct free_extent **t = &by_pos;
+
+	while (*t != e)
+		t = e->start < (*t)->start ? &(*t)->left : &(*t)->right;
+	*t = merge (e->left, e->right);
+	list_remove (&e->size_elem);
+}
+
+/* Indexes the CNT free sectors at START, using E if it is not null
+ * and a new extent otherwise.  If no memory is left the run stays
+ * free in the bitmap but cannot be allocated until the next
+ * build_extents(). */
+static void
+extent_new (struct free_extent *e, disk_sector_t start, size_t cnt) {
+	if (e == NULL)
+		e = slab_alloc (&extent_cache);
+	if (e == NULL)
+		return;
+	e->start = start;
+	e->cnt = cnt;
+	extent_add (e);
+}
+
+/* Returns the free extent with the last start at or before SECTOR,
+ * or a null pointer. */
+static struct free_extent *
+extent_floor (disk_sector_t sector) {
+	struct free_extent *t = by_pos, *found = NULL;
+
+	while (t != NULL)
+		if (t->start <= sector) {
+			found = t;
+			t = t->right;
+		} else
+			t = t->left;
+	return found;
+}
+
+/* Returns the free extent with the first start at or after SECTOR,
+ * or a null pointer. */
+static struct free_extent *
+extent_ceil (disk_sector_t sector) {
+	struct free_extent *t = by_pos, *found = NULL;
+
+	while (t != NULL)
+		if (t->start >= sector) {
+			found = t;
+			t = t->left;
+		} else
+			t = t->right;
+	return found;
+}
+
+/* Allocates the CNT sectors at SECTOR out of free extent E. */
+static void
+carve (struct free_extent *e, disk_sector_t sector, size_t cnt) {
+	disk_sector_t start = e->start, end = e->start + e->cnt;
+
+	ASSERT (start <= sector && sector + cnt <= end);
+
+	extent_del (e);
+	if (sector > start) {
+		extent_new (e, start, sector - start);
+		e = NULL;
+	}
+	if (sector + cnt < end) {
+		extent_new (e, sector + cnt, end - (sector + cnt));
+		e = NULL;
+	}
+	if (e != NULL)
+		slab_free (&extent_cache, e);
+
+	bitmap_set_multiple (free_map, sector, cnt, true);
+	mark_dirty (sector, cnt);
+}
+
+/* Returns the smallest free extent of at least CNT sectors, or a
+ * null pointer if there is none. */
+static struct free_extent *
+best_fit (size_t cnt) {
+	for (size_t k = class_of (cnt); k < SIZE_CLASSES; k++) {
+		struct free_extent *best = NULL;
+		struct list_elem *el;
+
+		for (el = list_begin (&size_class[k]); el != list_end (&size_class[k]);
+				el = list_next (el)) {
+			struct free_extent *e = list_entry (el, struct free_extent,
+					size_elem);
+			if (e->cnt >= cnt && (best == NULL || e->cnt < best->cnt)) {
+				best = e;
+				if (e->cnt == cnt)
+					break;
+			}
+		}
+		if (best != NULL)
+			return best;
+	}
+	return NULL;
+}
 
 /* Initializes the free map. */
 void
 free_map_init (void) {
+	lock_init (&free_map_lock);
+	for (size_t k = 0; k < SIZE_CLASSES; k++)
+		list_init (&size_class[k]);
+	slab_cache_init (&extent_cache, "free_extent", sizeof (struct free_extent));
 	free_map = bitmap_create (disk_size (filesys_disk));
 	if (free_map == NULL)
 		PANIC ("bitmap creation failed--disk is too large");
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
 	bitmap_mark (free_map, ROOT_DIR_SECTOR);
+	free_map_dirty = bitmap_create (DIV_ROUND_UP (bitmap_file_size (free_map),
+				DISK_SECTOR_SIZE));
+	if (free_map_dirty == NULL)
+		PANIC ("bitmap creation failed--disk is too large");
+	build_extents ();
+}
+
+/* Rebuilds the extent indexes from the bitmap. */
+static void
+build_extents (void) {
+	size_t size = bitmap_size (free_map);
+	size_t start = 0;
+
+	for (size_t k = 0; k < SIZE_CLASSES; k++)
+		while (!list_empty (&size_class[k]))
+			slab_free (&extent_cache, list_entry (list_pop_front (&size_class[k]),
+						struct free_extent, size_elem));
+	by_pos = NULL;
+
+	while (start < size
+			&& (start = bitmap_scan (free_map, start, 1, false)) != BITMAP_ERROR) {
+		size_t end = bitmap_scan (free_map, start, 1, true);
+		if (end == BITMAP_ERROR)
+			end = size;
+		extent_new (NULL, start, end - start);
+		start = end;
+	}
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
- * the first into *SECTORP.
+ * the first into *SECTORP, taking them from the smallest free extent
+ * big enough.  The change reaches the free map file at the next
+ * free_map_sync().
  * Returns true if successful, false if all sectors were
  * available. */
 bool
 free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
-	disk_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-	if (sector != BITMAP_ERROR
-			&& free_map_file != NULL
-			&& !bitmap_write (free_map, free_map_file)) {
-		bitmap_set_multiple (free_map, sector, cnt, false);
-		sector = BITMAP_ERROR;
+	struct free_extent *e;
+
+	lock_acquire (&free_map_lock);
+	e = best_fit (cnt);
+	if (e != NULL) {
+		*sectorp = e->start;
+		carve (e, e->start, cnt);
 	}
-	if (sector != BITMAP_ERROR)
-		*sectorp = sector;
-	return sector != BITMAP_ERROR;
+	lock_release (&free_map_lock);
+	return e != NULL;
 }
 
-/* Makes CNT sectors starting at SECTOR available for use. */
+/* Like free_map_allocate(), but a request of up to SMALL_ALLOC
+ * sectors takes the first free run at or after sector GOAL, such as
+ * the inode sector of the directory the new data belongs to, among
+ * the NEAR_TRIES extents that follow it. */
+bool
+free_map_allocate_near (size_t cnt, disk_sector_t goal,
+		disk_sector_t *sectorp) {
+	if (cnt <= SMALL_ALLOC) {
+		struct free_extent *e;
+		bool success = false;
+
+		lock_acquire (&free_map_lock);
+		e = extent_floor (goal);
+		if (e == NULL || e->start + e->cnt <= goal)
+			e = extent_ceil (goal);
+		for (int i = 0; i < NEAR_TRIES && e != NULL; i++) {
+			disk_sector_t sector = e->start > goal ? e->start : goal;
+			if (sector + cnt <= e->start + e->cnt) {
+				carve (e, sector, cnt);
+				*sectorp = sector;
+				success = true;
+				break;
+			}
+			e = extent_ceil (e->start + 1);
+		}
+		lock_release (&free_map_lock);
+		if (success)
+			return true;
+	}
+	return free_map_allocate (cnt, sectorp);
+}
+
+/* Allocates the CNT sectors starting at SECTOR, if all of them are
+ * free.  Returns true if successful. */
+bool
+free_map_allocate_at (disk_sector_t sector, size_t cnt) {
+	struct free_extent *e;
+	bool success = false;
+
+	lock_acquire (&free_map_lock);
+	e = extent_floor (sector);
+	if (e != NULL && sector + cnt <= e->start + e->cnt) {
+		carve (e, sector, cnt);
+		success = true;
+	}
+	lock_release (&free_map_lock);
+	return success;
+}
+
+/* Makes CNT sectors starting at SECTOR available for use, merging
+ * them with the free extents on either side. */
 void
 free_map_release (disk_sector_t sector, size_t cnt) {
+	struct free_extent *prev, *next, *e = NULL;
+	disk_sector_t start = sector, end = sector + cnt;
+
+	lock_acquire (&free_map_lock);
 	ASSERT (bitmap_all (free_map, sector, cnt));
 	bitmap_set_multiple (free_map, sector, cnt, false);
-	bitmap_write (free_map, free_map_file);
+	mark_dirty (sector, cnt);
+
+	prev = extent_floor (start);
+	if (prev != NULL && prev->start + prev->cnt == start) {
+		extent_del (prev);
+		start = prev->start;
+		e = prev;
+	}
+	next = extent_ceil (end);
+	if (next != NULL && next->start == end) {
+		extent_del (next);
+		end = next->start + next->cnt;
+		if (e == NULL)
+			e = next;
+		else
+			slab_free (&extent_cache, next);
+	}
+	extent_new (e, start, end - start);
+	lock_release (&free_map_lock);
+}
+
+/* Prints how the free space is split up: the number of free
+ * extents in each size class, the largest one, and how much of the
+ * free space lies outside it. */
+void
+free_map_report (void) {
+	size_t free_cnt, largest = 0, ext_cnt = 0;
+
+	if (free_map == NULL) {
+		printf ("Free map not in use.\n");
+		return;
+	}
+
+	lock_acquire (&free_map_lock);
+	free_cnt = bitmap_count (free_map, 0, bitmap_size (free_map), false);
+	printf ("Free space: %zu of %zu sectors free.\n",
+			free_cnt, bitmap_size (free_map));
+	for (size_t k = 0; k < SIZE_CLASSES; k++) {
+		size_t n = list_size (&size_class[k]);
+		struct list_elem *el;
+
+		if (n == 0)
+			continue;
+		for (el = list_begin (&size_class[k]); el != list_end (&size_class[k]);
+				el = list_next (el)) {
+			struct free_extent *e = list_entry (el, struct free_extent,
+					size_elem);
+			if (e->cnt > largest)
+				largest = e->cnt;
+		}
+		printf ("  %8zu+ sectors: %zu extents\n", (size_t) 1 << k, n);
+		ext_cnt += n;
+	}
+	printf ("%zu free extents, largest %zu sectors", ext_cnt, largest);
+	if (free_cnt > 0)
+		printf (", %zu%% fragmented", 100 - largest * 100 / free_cnt);
+	printf (".\n");
+	lock_release (&free_map_lock);
+}
+
+/* Writes the parts of the free map that changed since the last call
+ * to the free map file, in order, one write per run of changed
+ * sectors. */
+void
+free_map_sync (void) {
+	size_t start = 0;
+
+	lock_acquire (&free_map_lock);
+	if (free_map_file != NULL)
+		while ((start = bitmap_scan (free_map_dirty, start, 1, true))
+				!= BITMAP_ERROR) {
+			size_t end = start + 1;
+			while (end < bitmap_size (free_map_dirty)
+					&& bitmap_test (free_map_dirty, end))
+				end++;
+			if (!bitmap_write_range (free_map, free_map_file,
+						start * DISK_SECTOR_SIZE, (end - start) * DISK_SECTOR_SIZE))
+				PANIC ("can't write free map");
+			bitmap_set_multiple (free_map_dirty, start, end - start, false);
+			start = end;
+		}
+	lock_release (&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -52,11 +426,15 @@ free_map_open (void) {
 		PANIC ("can't open free map");
 	if (!bitmap_read (free_map, free_map_file))
 		PANIC ("can't read free map");
+	lock_acquire (&free_map_lock);
+	build_extents ();
+	lock_release (&free_map_lock);
 }
 
 /* Writes the free map to disk and closes the free map file. */
 void
 free_map_close (void) {
+	free_map_sync ();
 	file_close (free_map_file);
 }
 
@@ -74,4 +452,5 @@ free_map_create (void) {
 		PANIC ("can't open free map");
 	if (!bitmap_write (free_map, free_map_file))
 		PANIC ("can't write free map");
+	bitmap_set_all (free_map_dirty, false);
 }
@@ -6,6 +6,7 @@
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/free-map.h"
 #include "devices/disk.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
@@ -26,6 +27,12 @@ fsutil_ls (char **argv UNUSED) {
 	printf ("End of listing.\n");
 }
 
+/* Reports how fragmented the free space on the file system disk is. */
+void
+fsutil_df (char **argv UNUSED) {
+	free_map_report ();
+}
+
 /* Prints the contents of file ARGV[1] to the system console as
  * hex and ASCII. */
 void
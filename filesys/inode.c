@@ -1,22 +1,42 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
-#include "threads/malloc.h"
+#include "threads/interrupt.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A run of CNT consecutive data sectors starting at disk sector
+ * START, holding sectors FIRST through FIRST + CNT - 1 of the file. */
+struct extent {
+	uint32_t first;                     /* First file sector. */
+	disk_sector_t start;                /* First disk sector. */
+	uint32_t cnt;                       /* Number of sectors. */
+};
+
+/* Extents kept in the inode sector and in its index sector. */
+#define INLINE_EXTENTS 41
+#define INDEX_EXTENTS (DISK_SECTOR_SIZE / sizeof (struct extent))
+#define MAX_EXTENTS (INLINE_EXTENTS + INDEX_EXTENTS)
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * The first INLINE_EXTENTS extents of the file are stored here, in
+ * order of file position, and the rest in sector INDEX. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	uint32_t ext_cnt;                   /* Number of extents in use. */
+	disk_sector_t index;                /* Overflow extents, or 0. */
+	struct extent ext[INLINE_EXTENTS];  /* Inline extents. */
+	uint32_t unused[1];                 /* Not used. */
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -28,35 +48,259 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem elem;              /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	uint64_t generation;                /* Changes whenever data changes. */
+	struct lock lock;                   /* Serializes writes to this inode. */
 	struct inode_disk data;             /* Inode content. */
+	struct extent index[INDEX_EXTENTS]; /* Contents of sector DATA.INDEX. */
 };
 
+/* Source of inode generation numbers.  Each in-memory inode takes a
+ * fresh number when it is opened and again on every write, so a
+ * (inode, generation) pair never names two different contents.
+ * Writers of different inodes bump it concurrently, so it is only
+ * touched through new_generation(). */
+static uint64_t next_generation;
+
+/* Returns a generation number never returned before. */
+static uint64_t
+new_generation (void) {
+	enum intr_level old_level = intr_disable ();
+	uint64_t generation = ++next_generation;
+	intr_set_level (old_level);
+	return generation;
+}
+
+/* Returns INODE's extent number I. */
+static struct extent *
+extent_at (struct inode *inode, size_t i) {
+	return i < INLINE_EXTENTS
+		? &inode->data.ext[i] : &inode->index[i - INLINE_EXTENTS];
+}
+
+/* Returns the number of data sectors allocated to INODE. */
+static size_t
+inode_sectors (struct inode *inode) {
+	struct extent *e;
+
+	if (inode->data.ext_cnt == 0)
+		return 0;
+	e = extent_at (inode, inode->data.ext_cnt - 1);
+	return e->first + e->cnt;
+}
+
 /* Returns the disk sector that contains byte offset POS within
- * INODE.
+ * INODE, found by binary search of its extents.
  * Returns -1 if INODE does not contain data for a byte at offset
  * POS. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
+	size_t sector, lo, hi;
+	struct extent *e;
+
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
-	else
+	if (pos >= inode->data.length)
 		return -1;
+
+	sector = pos / DISK_SECTOR_SIZE;
+	lo = 0;
+	hi = inode->data.ext_cnt;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (extent_at (inode, mid)->first <= sector)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	e = extent_at (inode, lo);
+	return e->start + (sector - e->first);
+}
+
+/* Writes INODE's on-disk inode and index sector. */
+static void
+inode_write_disk (struct inode *inode) {
+	cache_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	if (inode->data.index != 0)
+		cache_write (inode->data.index, inode->index, 0, sizeof inode->index);
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Appends the CNT sectors at START to INODE's data, extending its
+ * last extent if they follow on from it.  Returns false if INODE
+ * has no room for another extent or its index sector cannot be
+ * allocated. */
+static bool
+add_run (struct inode *inode, disk_sector_t start, size_t cnt) {
+	size_t n = inode->data.ext_cnt;
+	struct extent *e;
+
+	if (n > 0) {
+		e = extent_at (inode, n - 1);
+		if (e->start + e->cnt == start) {
+			e->cnt += cnt;
+			return true;
+		}
+	}
+
+	if (n == MAX_EXTENTS)
+		return false;
+	if (n == INLINE_EXTENTS && inode->data.index == 0) {
+		if (!free_map_allocate_near (1, inode->sector, &inode->data.index))
+			return false;
+		memset (inode->index, 0, sizeof inode->index);
+	}
+
+	e = extent_at (inode, n);
+	e->first = inode_sectors (inode);
+	e->start = start;
+	e->cnt = cnt;
+
+	/* Lock-free readers look only at extents below EXT_CNT. */
+	barrier ();
+	inode->data.ext_cnt++;
+	return true;
+}
+
+/* Extends INODE to LENGTH bytes, filling the new sectors with zeros.
+ * Sectors are taken right after the file's last extent if they are
+ * free, otherwise in the best-fitting runs the free map can supply,
+ * with small runs kept close to the file.
+ * Returns false if the disk is full or INODE runs out of extents,
+ * in which case INODE is left as it was. */
+static bool
+inode_grow (struct inode *inode, off_t length) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t want = bytes_to_sectors (length);
+	size_t have = inode_sectors (inode);
+	size_t need = want > have ? want - have : 0;
+	size_t old_cnt = inode->data.ext_cnt;
+	uint32_t old_last = old_cnt > 0 ? extent_at (inode, old_cnt - 1)->cnt : 0;
+	disk_sector_t old_index = inode->data.index;
+	bool success = true;
+
+	while (need > 0 && success) {
+		size_t cnt = need;
+		disk_sector_t start;
+		struct extent *last = inode->data.ext_cnt > 0
+			? extent_at (inode, inode->data.ext_cnt - 1) : NULL;
+
+		if (last != NULL
+				&& free_map_allocate_at (last->start + last->cnt, cnt))
+			start = last->start + last->cnt;
+		else
+			while (!free_map_allocate_near (cnt,
+						last != NULL ? last->start + last->cnt : inode->sector,
+						&start))
+				if ((cnt /= 2) == 0)
+					break;
+		if (cnt == 0) {
+			success = false;
+			break;
+		}
+
+		for (size_t i = 0; i < cnt; i++)
+			cache_write (start + i, zeros, 0, DISK_SECTOR_SIZE);
+		if (!add_run (inode, start, cnt)) {
+			free_map_release (start, cnt);
+			success = false;
+			break;
+		}
+		need -= cnt;
+	}
+
+	if (!success) {
+		/* Give back everything this call took.  Readers never look
+		 * past LENGTH, which has not moved, so they cannot see it. */
+		size_t cnt = inode->data.ext_cnt;
+		struct extent *e;
+
+		inode->data.ext_cnt = old_cnt;
+		barrier ();
+		if (old_cnt > 0) {
+			e = extent_at (inode, old_cnt - 1);
+			if (e->cnt > old_last)
+				free_map_release (e->start + old_last, e->cnt - old_last);
+			e->cnt = old_last;
+		}
+		for (size_t i = old_cnt; i < cnt; i++) {
+			e = extent_at (inode, i);
+			free_map_release (e->start, e->cnt);
+		}
+		if (old_index == 0 && inode->data.index != 0) {
+			free_map_release (inode->data.index, 1);
+			inode->data.index = 0;
+		}
+		return false;
+	}
+
+	/* Readers trust LENGTH, so publish it after the extents. */
+	if (length > inode->data.length) {
+		barrier ();
+		inode->data.length = length;
+	}
+	inode_write_disk (inode);
+	return true;
+}
+
+/* Returns every sector INODE's data occupies to the free map. */
+static void
+inode_release (struct inode *inode) {
+	for (size_t i = 0; i < inode->data.ext_cnt; i++) {
+		struct extent *e = extent_at (inode, i);
+		free_map_release (e->start, e->cnt);
+	}
+	if (inode->data.index != 0)
+		free_map_release (inode->data.index, 1);
+}
+
+/* Open inodes, keyed by sector, so that opening a single inode
+ * twice returns the same `struct inode'. */
+static struct hash open_inodes;
+
+/* Protects open_inodes and the REMOVED member of every inode in it.
+ * Openers that find their inode already open hold it only for
+ * reading, so they search the table in parallel; adding and removing
+ * inodes needs it for writing.  OPEN_CNT only ever drops under the
+ * write lock, so readers may raise it with interrupts disabled.
+ * Never held across disk I/O. */
+static struct rwlock open_inodes_lock;
+
+/* Where struct inodes come from. */
+static struct slab_cache inode_cache;
+
+static hash_hash_func inode_hash;
+static hash_less_func inode_less;
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&open_inodes, inode_hash, inode_less, NULL);
+	rwlock_init (&open_inodes_lock);
+	slab_cache_init (&inode_cache, "inode", sizeof (struct inode));
+}
+
+/* Returns the open inode for SECTOR, or a null pointer if it is not
+ * open.  The caller must hold open_inodes_lock. */
+static struct inode *
+find_open (disk_sector_t sector) {
+	struct inode key;
+	struct hash_elem *e;
+
+	key.sector = sector;
+	e = hash_find (&open_inodes, &key.elem);
+	return e != NULL ? hash_entry (e, struct inode, elem) : NULL;
+}
+
+/* Adds a reference to open INODE.  The caller must hold
+ * open_inodes_lock, for reading at least. */
+static void
+get_ref (struct inode *inode) {
+	enum intr_level old_level = intr_disable ();
+	inode->open_cnt++;
+	intr_set_level (old_level);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -66,33 +310,22 @@ inode_init (void) {
  * Returns false if memory or disk allocation fails. */
 bool
 inode_create (disk_sector_t sector, off_t length) {
-	struct inode_disk *disk_inode = NULL;
-	bool success = false;
+	struct inode *inode;
+	bool success;
 
 	ASSERT (length >= 0);
 
 	/* If this assertion fails, the inode structure is not exactly
 	 * one sector in size, and you should fix that. */
-	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
-
-	disk_inode = calloc (1, sizeof *disk_inode);
-	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
-		disk_inode->length = length;
-		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
-		free (disk_inode);
-	}
+	ASSERT (sizeof (struct inode_disk) == DISK_SECTOR_SIZE);
+
+	inode = slab_zalloc (&inode_cache);
+	if (inode == NULL)
+		return false;
+	inode->sector = sector;
+	inode->data.magic = INODE_MAGIC;
+	success = inode_grow (inode, length);
+	slab_free (&inode_cache, inode);
 	return success;
 }
 
@@ -101,39 +334,66 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode *inode, *new;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
+	rwlock_read_acquire (&open_inodes_lock);
+	inode = find_open (sector);
+	if (inode != NULL)
+		get_ref (inode);
+	rwlock_read_release (&open_inodes_lock);
+
+	if (inode == NULL) {
+		/* Allocate memory. */
+		new = slab_alloc (&inode_cache);
+		if (new == NULL)
+			return NULL;
+
+		/* Look again, now exclusively: another thread may have
+		 * opened it in the meantime. */
+		rwlock_write_acquire (&open_inodes_lock);
+		inode = find_open (sector);
+		if (inode == NULL) {
+			/* Initialize.  The inode's own lock is held until its
+			 * contents have been read, so that another opener who
+			 * finds it in the table in the meantime waits for them. */
+			inode = new;
+			inode->sector = sector;
+			inode->open_cnt = 1;
+			inode->deny_write_cnt = 0;
+			inode->removed = false;
+			inode->generation = new_generation ();
+			lock_init (&inode->lock);
+			lock_acquire (&inode->lock);
+			hash_insert (&open_inodes, &inode->elem);
+			rwlock_write_release (&open_inodes_lock);
+
+			cache_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+			if (inode->data.index != 0)
+				cache_read (inode->data.index, inode->index, 0,
+						sizeof inode->index);
+			lock_release (&inode->lock);
+			return inode;
 		}
+		inode->open_cnt++;
+		rwlock_write_release (&open_inodes_lock);
+		slab_free (&inode_cache, new);
 	}
 
-	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
-	if (inode == NULL)
-		return NULL;
-
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
-	inode->sector = sector;
-	inode->open_cnt = 1;
-	inode->deny_write_cnt = 0;
-	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	/* Wait until the first opener has read it in. */
+	lock_acquire (&inode->lock);
+	lock_release (&inode->lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
-		inode->open_cnt++;
+	if (inode != NULL) {
+		rwlock_read_acquire (&open_inodes_lock);
+		get_ref (inode);
+		rwlock_read_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -153,18 +413,34 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	rwlock_write_acquire (&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		/* Remove from the table and release lock. */
+		hash_delete (&open_inodes, &inode->elem);
+		rwlock_write_release (&open_inodes_lock);
 
-		/* Deallocate blocks if removed. */
+		/* Deallocate blocks if removed, otherwise write back its
+		 * dirty sectors. */
 		if (inode->removed) {
 			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
+			inode_release (inode);
+		} else
+			inode_flush (inode);
+
+		slab_free (&inode_cache, inode);
+	} else
+		rwlock_write_release (&open_inodes_lock);
+}
 
-		free (inode); 
+/* Writes INODE's dirty sectors in the buffer cache to disk. */
+void
+inode_flush (struct inode *inode) {
+	cache_flush_range (inode->sector, 1);
+	if (inode->data.index != 0)
+		cache_flush_range (inode->data.index, 1);
+	for (size_t i = 0; i < inode->data.ext_cnt; i++) {
+		struct extent *e = extent_at (inode, i);
+		cache_flush_range (e->start, e->cnt);
 	}
 }
 
@@ -173,25 +449,87 @@ inode_close (struct inode *inode) {
 void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
+	rwlock_write_acquire (&open_inodes_lock);
 	inode->removed = true;
+	rwlock_write_release (&open_inodes_lock);
+}
+
+/* Position within a list of iovecs. */
+struct iov_iter {
+	const struct iovec *iov;    /* Current buffer. */
+	int cnt;                    /* Buffers left, including IOV. */
+	size_t ofs;                 /* Offset within IOV. */
+};
+
+static void
+iter_init (struct iov_iter *it, const struct iovec *iov, int cnt) {
+	it->iov = iov;
+	it->cnt = cnt;
+	it->ofs = 0;
+}
+
+/* Returns the total number of bytes in the CNT buffers of IOV. */
+static off_t
+iov_total (const struct iovec *iov, int cnt) {
+	off_t total = 0;
+	for (int i = 0; i < cnt; i++)
+		total += iov[i].iov_len;
+	return total;
+}
+
+/* Returns the address of the next contiguous run of at most LEN bytes
+ * of IT, stores its length in *N and advances IT past it. */
+static uint8_t *
+iter_next (struct iov_iter *it, size_t len, size_t *n) {
+	uint8_t *p;
+
+	while (it->ofs == it->iov->iov_len) {
+		ASSERT (it->cnt > 1);
+		it->iov++;
+		it->cnt--;
+		it->ofs = 0;
+	}
+	*n = it->iov->iov_len - it->ofs;
+	if (*n > len)
+		*n = len;
+	p = (uint8_t *) it->iov->iov_base + it->ofs;
+	it->ofs += *n;
+	return p;
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
  * than SIZE if an error occurs or end of file is reached. */
 off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
-	uint8_t *buffer = buffer_;
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) {
+	struct iovec iov = { buffer, size };
+	return inode_readv (inode, &iov, 1, offset);
+}
+
+/* Reads from INODE, starting at position OFFSET, into the IOV_CNT
+ * buffers of IOV in order, filling each before moving to the next.
+ * Each sector is read once even if it spans several buffers.
+ * Returns the number of bytes actually read, which may be less than
+ * the total if an error occurs or end of file is reached.
+ * Takes no lock, so readers of one file proceed in parallel.  A
+ * writer only ever appends extents and publishes a new length after
+ * them, so every byte below the length read on entry stays mapped. */
+off_t
+inode_readv (struct inode *inode, const struct iovec *iov, int iov_cnt,
+		off_t offset) {
+	struct iov_iter it;
+	off_t size = iov_total (iov, iov_cnt);
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
+	off_t length = inode_length (inode);
 
+	iter_init (&it, iov, iov_cnt);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
-		off_t inode_left = inode_length (inode) - offset;
+		off_t inode_left = length - offset;
 		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
 		int min_left = inode_left < sector_left ? inode_left : sector_left;
 
@@ -200,19 +538,13 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+		/* Copy out of the cache, one contiguous piece of the
+		 * caller's buffers at a time. */
+		for (int done = 0; done < chunk_size; ) {
+			size_t n;
+			uint8_t *dst = iter_next (&it, chunk_size - done, &n);
+			cache_read (sector_idx, dst, sector_ofs + done, n);
+			done += n;
 		}
 
 		/* Advance. */
@@ -220,26 +552,48 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+
+	/* Start fetching the sector after the last one read. */
+	if (bytes_read > 0
+			&& ROUND_UP (offset, DISK_SECTOR_SIZE) < length)
+		cache_read_ahead (byte_to_sector (inode,
+					ROUND_UP (offset, DISK_SECTOR_SIZE)));
 
 	return bytes_read;
 }
 
-/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+ * extending INODE if the write ends past end of file.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the disk fills up or an error occurs. */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
 		off_t offset) {
-	const uint8_t *buffer = buffer_;
+	struct iovec iov = { (void *) buffer, size };
+	return inode_writev (inode, &iov, 1, offset);
+}
+
+/* Writes the IOV_CNT buffers of IOV, in order, into INODE starting at
+ * OFFSET, as one write: each sector is written once and no other
+ * writer can interleave.  Extends INODE if the write ends past end of
+ * file.  Returns the number of bytes actually written, which may be
+ * less than the total if the disk fills up or an error occurs. */
+off_t
+inode_writev (struct inode *inode, const struct iovec *iov, int iov_cnt,
+		off_t offset) {
+	struct iov_iter it;
+	off_t size = iov_total (iov, iov_cnt);
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	lock_acquire (&inode->lock);
+	if (inode->deny_write_cnt) {
+		lock_release (&inode->lock);
 		return 0;
+	}
+	if (offset + size > inode_length (inode))
+		inode_grow (inode, offset + size);
 
+	iter_init (&it, iov, iov_cnt);
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -255,26 +609,13 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
+		/* Copy into the cache, which writes the sector back later.
+		 * A partial sector is read in first unless it is cached. */
+		for (int done = 0; done < chunk_size; ) {
+			size_t n;
+			uint8_t *src = iter_next (&it, chunk_size - done, &n);
+			cache_write (sector_idx, src, sector_ofs + done, n);
+			done += n;
 		}
 
 		/* Advance. */
@@ -282,8 +623,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
 
+	if (bytes_written > 0)
+		inode->generation = new_generation ();
+	lock_release (&inode->lock);
 	return bytes_written;
 }
 
@@ -292,8 +635,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	lock_acquire (&inode->lock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	lock_release (&inode->lock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +646,19 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	lock_acquire (&inode->lock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	lock_release (&inode->lock);
+}
+
+/* Returns INODE's generation number.  It changes whenever INODE's
+ * data is written, so callers that cache something derived from the
+ * contents can tell whether it is still current. */
+uint64_t
+inode_get_generation (const struct inode *inode) {
+	return inode->generation;
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -311,3 +666,15 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode, elem)->sector);
+}
+
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode, elem)->sector
+		< hash_entry (b, struct inode, elem)->sector;
+}
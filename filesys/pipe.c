@@ -0,0 +1,157 @@
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A pipe: a one-page ring buffer with a read end and a write end.
+
+   Readers wait while the pipe is empty and some write end is open;
+   once every write end is closed, reads return what is left and then
+   0.  Writers wait while the pipe is full and some read end is open;
+   once every read end is closed, writes fail.  Head and tail run
+   freely; index the buffer with them modulo PIPE_SIZE. */
+#define PIPE_SIZE PGSIZE
+
+struct pipe {
+	uint8_t *buf;               /* PIPE_SIZE bytes. */
+	size_t head;                /* Next byte to read. */
+	size_t tail;                /* Next byte to write. */
+	int readers;                /* Open read ends. */
+	int writers;                /* Open write ends. */
+	struct lock lock;           /* Protects all of the above. */
+	struct condition not_empty; /* Signaled when data arrives. */
+	struct condition not_full;  /* Signaled when room appears. */
+};
+
+/* Creates a pipe with one read end and one write end open.  Returns
+ * a null pointer if memory is exhausted. */
+struct pipe *
+pipe_create (void) {
+	struct pipe *p = malloc (sizeof *p);
+	if (p == NULL)
+		return NULL;
+	p->buf = palloc_get_page (0);
+	if (p->buf == NULL) {
+		free (p);
+		return NULL;
+	}
+	p->head = p->tail = 0;
+	p->readers = p->writers = 1;
+	lock_init (&p->lock);
+	cond_init (&p->not_empty);
+	cond_init (&p->not_full);
+	return p;
+}
+
+/* Opens another read end, or write end if WRITER, of P. */
+void
+pipe_open_end (struct pipe *p, bool writer) {
+	lock_acquire (&p->lock);
+	if (writer)
+		p->writers++;
+	else
+		p->readers++;
+	lock_release (&p->lock);
+}
+
+/* Closes a read end, or write end if WRITER, of P, and frees P when
+ * both kinds of end are all closed. */
+void
+pipe_close_end (struct pipe *p, bool writer) {
+	bool dead;
+
+	lock_acquire (&p->lock);
+	if (writer) {
+		ASSERT (p->writers > 0);
+		if (--p->writers == 0)
+			cond_broadcast (&p->not_empty, &p->lock);
+	} else {
+		ASSERT (p->readers > 0);
+		if (--p->readers == 0)
+			cond_broadcast (&p->not_full, &p->lock);
+	}
+	dead = p->readers == 0 && p->writers == 0;
+	lock_release (&p->lock);
+
+	if (dead) {
+		palloc_free_page (p->buf);
+		free (p);
+	}
+}
+
+/* Reads from P into the IOV_CNT buffers of IOV, in order.  Waits
+ * for data only while nothing has been read, so the call returns as
+ * soon as some data is available.  Returns the number of bytes read,
+ * which is 0 at end of file, when P is empty and has no write ends. */
+off_t
+pipe_readv (struct pipe *p, const struct iovec *iov, int iov_cnt) {
+	off_t bytes_read = 0;
+
+	lock_acquire (&p->lock);
+	while (p->head == p->tail && p->writers > 0)
+		cond_wait (&p->not_empty, &p->lock);
+
+	for (int i = 0; i < iov_cnt && p->head != p->tail; i++) {
+		size_t done = 0;
+		while (done < iov[i].iov_len && p->head != p->tail) {
+			size_t ofs = p->head % PIPE_SIZE;
+			size_t chunk = p->tail - p->head;
+			if (chunk > PIPE_SIZE - ofs)
+				chunk = PIPE_SIZE - ofs;
+			if (chunk > iov[i].iov_len - done)
+				chunk = iov[i].iov_len - done;
+			memcpy ((uint8_t *) iov[i].iov_base + done, p->buf + ofs, chunk);
+			p->head += chunk;
+			done += chunk;
+		}
+		bytes_read += done;
+	}
+	if (bytes_read > 0)
+		cond_broadcast (&p->not_full, &p->lock);
+	lock_release (&p->lock);
+	return bytes_read;
+}
+
+/* Writes the IOV_CNT buffers of IOV, in order, to P, waiting for
+ * room as needed.  Returns the number of bytes written, which is
+ * short only if every read end is closed; -1 if that happened before
+ * anything was written. */
+off_t
+pipe_writev (struct pipe *p, const struct iovec *iov, int iov_cnt) {
+	off_t bytes_written = 0;
+	bool broken;
+
+	lock_acquire (&p->lock);
+	for (int i = 0; i < iov_cnt; i++) {
+		size_t done = 0;
+		while (done < iov[i].iov_len) {
+			size_t ofs = p->tail % PIPE_SIZE;
+			size_t chunk = PIPE_SIZE - (p->tail - p->head);
+
+			while (chunk == 0 && p->readers > 0) {
+				cond_wait (&p->not_full, &p->lock);
+				chunk = PIPE_SIZE - (p->tail - p->head);
+			}
+			if (p->readers == 0)
+				goto done;
+
+			if (chunk > PIPE_SIZE - ofs)
+				chunk = PIPE_SIZE - ofs;
+			if (chunk > iov[i].iov_len - done)
+				chunk = iov[i].iov_len - done;
+			memcpy (p->buf + ofs, (const uint8_t *) iov[i].iov_base + done, chunk);
+			p->tail += chunk;
+			done += chunk;
+			bytes_written += chunk;
+			cond_broadcast (&p->not_empty, &p->lock);
+		}
+	}
+
+done:
+	broken = p->readers == 0;
+	lock_release (&p->lock);
+	return bytes_written == 0 && broken ? -1 : bytes_written;
+}
@@ -2,11 +2,16 @@
 #define DEVICES_INPUT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <tty.h>
 
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
+size_t input_read (void *, size_t);
+size_t input_read_nowait (void *, size_t);
 bool input_full (void);
+enum tty_mode input_set_mode (enum tty_mode);
 
 #endif /* devices/input.h */
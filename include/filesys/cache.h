@@ -0,0 +1,22 @@
+#ifndef FILESYS_CACHE_H
+#define FILESYS_CACHE_H
+
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* Default number of sectors in the buffer cache. */
+#define CACHE_DEFAULT_SIZE 64
+
+/* -bc: Number of sectors in the buffer cache. */
+extern size_t cache_size;
+
+void cache_init (void);
+void cache_done (void);
+void cache_read (disk_sector_t, void *buffer, size_t ofs, size_t size);
+void cache_write (disk_sector_t, const void *buffer, size_t ofs, size_t size);
+void cache_read_ahead (disk_sector_t);
+void cache_flush (void);
+void cache_flush_range (disk_sector_t start, size_t cnt);
+void cache_print_stats (void);
+
+#endif /* filesys/cache.h */
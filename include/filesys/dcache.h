@@ -0,0 +1,19 @@
+#ifndef FILESYS_DCACHE_H
+#define FILESYS_DCACHE_H
+
+#include <stdbool.h>
+#include "devices/disk.h"
+
+/* Child sector recorded for a name known not to exist.  Sector 0
+ * holds the free map, so it is never a directory entry. */
+#define DCACHE_NEGATIVE 0
+
+void dcache_init (void);
+bool dcache_lookup (disk_sector_t parent, const char *name,
+		disk_sector_t *child);
+void dcache_insert (disk_sector_t parent, const char *name,
+		disk_sector_t child);
+void dcache_invalidate (disk_sector_t parent, const char *name);
+void dcache_print_stats (void);
+
+#endif /* filesys/dcache.h */
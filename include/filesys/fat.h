@@ -23,10 +23,12 @@ void fat_open (void);
 void fat_close (void);
 void fat_create (void);
 void fat_close (void);
+void fat_sync (void);
 
 cluster_t fat_create_chain (
     cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
 );
+cluster_t fat_create_chain_n (cluster_t clst, size_t cnt);
 void fat_remove_chain (
     cluster_t clst, /* Cluster # to be removed */
     cluster_t pclst /* Previous cluster of clst, 0: clst is the start of chain */
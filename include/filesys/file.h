@@ -1,6 +1,8 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <iovec.h>
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
@@ -9,14 +11,24 @@ struct inode;
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_dup (struct file *file);
+bool file_is_shared (struct file *file);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
 
+/* Pipes. */
+bool file_open_pipe (struct file **read_end, struct file **write_end);
+bool file_is_pipe (struct file *);
+
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
 off_t file_write (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+off_t file_readv (struct file *, const struct iovec *, int iov_cnt);
+off_t file_writev (struct file *, const struct iovec *, int iov_cnt);
+off_t file_copy_range (struct file *in, off_t in_ofs, struct file *out,
+		off_t out_ofs, off_t size);
 
 /* Preventing writes. */
 void file_deny_write (struct file *);
@@ -1,7 +1,9 @@
 #ifndef FILESYS_INODE_H
 #define FILESYS_INODE_H
 
+#include <iovec.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 
@@ -12,10 +14,16 @@ bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
 struct inode *inode_reopen (struct inode *);
 disk_sector_t inode_get_inumber (const struct inode *);
+uint64_t inode_get_generation (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
+void inode_flush (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_readv (struct inode *, const struct iovec *, int iov_cnt,
+		off_t offset);
+off_t inode_writev (struct inode *, const struct iovec *, int iov_cnt,
+		off_t offset);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
@@ -0,0 +1,16 @@
+#ifndef FILESYS_PIPE_H
+#define FILESYS_PIPE_H
+
+#include <iovec.h>
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct pipe;
+
+struct pipe *pipe_create (void);
+void pipe_open_end (struct pipe *, bool writer);
+void pipe_close_end (struct pipe *, bool writer);
+off_t pipe_readv (struct pipe *, const struct iovec *, int iov_cnt);
+off_t pipe_writev (struct pipe *, const struct iovec *, int iov_cnt);
+
+#endif /* filesys/pipe.h */
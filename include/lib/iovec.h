@@ -0,0 +1,15 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+#include <stddef.h>
+
+/* One buffer of a vectored read or write. */
+struct iovec {
+	void *iov_base;             /* Start of the buffer. */
+	size_t iov_len;             /* Length of the buffer in bytes. */
+};
+
+/* Maximum number of buffers in one readv() or writev(). */
+#define IOV_MAX 1024
+
+#endif /* lib/iovec.h */
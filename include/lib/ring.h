@@ -0,0 +1,59 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+#include <stdint.h>
+
+/* Submission and completion rings for batched file I/O.
+
+   ring_setup() maps one page into the calling process, laid out as a
+   struct ring.  The process fills submission queue entries at
+   SQ_TAIL and advances it; ring_enter() makes the kernel execute the
+   queued entries in order, advance SQ_HEAD past them and post one
+   completion per entry at CQ_TAIL.  The process consumes completions
+   and advances CQ_HEAD.  Head and tail counters run freely; index the
+   arrays with the counter modulo the number of entries. */
+
+/* Maximum number of submission queue entries.  The completion queue
+   is twice as large. */
+#define RING_MAX_ENTRIES 32
+
+/* Operations. */
+enum ring_op {
+	RING_OP_NOP,                /* Do nothing; completes with 0. */
+	RING_OP_READ,               /* read (FD, ADDR, LEN). */
+	RING_OP_WRITE,              /* write (FD, ADDR, LEN). */
+	RING_OP_OPEN,               /* open (ADDR). */
+	RING_OP_CLOSE,              /* close (FD). */
+	RING_OP_PREAD,              /* pread (FD, ADDR, LEN, OFF). */
+	RING_OP_FSYNC,              /* Flush FD's data to disk. */
+};
+
+/* Submission queue entry. */
+struct ring_sqe {
+	uint8_t opcode;             /* One of enum ring_op. */
+	int32_t fd;                 /* File descriptor. */
+	uint64_t addr;              /* Buffer or file name. */
+	uint32_t len;               /* Buffer length. */
+	int64_t off;                /* File offset for RING_OP_PREAD. */
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* Completion queue entry. */
+struct ring_cqe {
+	uint64_t user_data;         /* From the submission. */
+	int32_t res;                /* What the equivalent call returns. */
+};
+
+/* The shared page. */
+struct ring {
+	uint32_t sq_head;           /* Advanced by the kernel. */
+	uint32_t sq_tail;           /* Advanced by the process. */
+	uint32_t sq_entries;        /* Size of SQES. */
+	uint32_t cq_head;           /* Advanced by the process. */
+	uint32_t cq_tail;           /* Advanced by the kernel. */
+	uint32_t cq_entries;        /* Size of CQES. */
+	struct ring_sqe sqes[RING_MAX_ENTRIES];
+	struct ring_cqe cqes[2 * RING_MAX_ENTRIES];
+};
+
+#endif /* lib/ring.h */
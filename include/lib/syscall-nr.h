@@ -36,6 +36,32 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Process creation without fork. */
+	SYS_SPAWN,                  /* Create a process from an executable. */
+
+	/* Positioned and vectored I/O. */
+	SYS_PREAD,                  /* Read from a file at an offset. */
+	SYS_PWRITE,                 /* Write to a file at an offset. */
+	SYS_READV,                  /* Read into several buffers. */
+	SYS_WRITEV,                 /* Write from several buffers. */
+	SYS_COPY_FILE_RANGE,        /* Copy data between two files. */
+
+	/* Batched I/O. */
+	SYS_RING_SETUP,             /* Map a submission/completion ring. */
+	SYS_RING_ENTER,             /* Execute queued ring submissions. */
+
+	/* Debugging. */
+	SYS_STRACE,                 /* Trace this process's system calls. */
+
+	/* Console. */
+	SYS_TTYMODE,                /* Set the console input mode. */
+
+	/* Inter-process communication. */
+	SYS_PIPE,                   /* Create a pipe. */
+	SYS_SHM_OPEN,               /* Open a shared memory segment. */
+	SYS_SHM_MAP,                /* Map a shared memory segment. */
+	SYS_SHM_UNMAP,              /* Unmap a shared memory segment. */
 };
 
 #endif /* lib/syscall-nr.h */
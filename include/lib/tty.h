@@ -0,0 +1,10 @@
+#ifndef __LIB_TTY_H
+#define __LIB_TTY_H
+
+/* Console input modes. */
+enum tty_mode {
+	TTY_RAW,                    /* Bytes are readable as they arrive. */
+	TTY_CANON,                  /* Line at a time, with erase. */
+};
+
+#endif /* lib/tty.h */
@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <iovec.h>
+#include <ring.h>
+#include <tty.h>
 #include <stddef.h>
 
 /* Process identifier. */
@@ -38,6 +41,36 @@ void close (int fd);
 
 int dup2(int oldfd, int newfd);
 
+/* Descriptor remapping for spawn(): CHILD_FD in the new process
+   refers to a duplicate of the caller's PARENT_FD. */
+struct spawn_fd {
+	int parent_fd;
+	int child_fd;
+};
+
+pid_t spawn (const char *cmd_line, const struct spawn_fd *fds, size_t fd_cnt);
+
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iov_cnt);
+int writev (int fd, const struct iovec *iov, int iov_cnt);
+int copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+                     unsigned length);
+struct ring *ring_setup (unsigned entries);
+int ring_enter (unsigned to_submit);
+
+/* Read from the kernel data pages, without a system call. */
+int64_t vdso_ticks (void);
+int64_t vdso_time_ns (void);
+pid_t vdso_getpid (void);
+
+bool strace (bool enable);
+int ttymode (int mode);
+int pipe (int fds[2]);
+int shm_open (const char *name, size_t size);
+void *shm_map (int id, void *addr);
+int shm_unmap (void *addr);
+
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
@@ -0,0 +1,40 @@
+#ifndef __LIB_VDSO_H
+#define __LIB_VDSO_H
+
+#include <stdint.h>
+
+/* Kernel data pages mapped read-only into every process.
+
+   The time page is one frame shared by all processes and rewritten by
+   the timer interrupt.  Readers retry while SEQ is odd or changes
+   under them, so they never see a half-updated tick.  The process
+   page is private and holds the process's identity.  Reading either
+   costs a memory load instead of a system call. */
+
+/* User addresses of the two pages. */
+#define VDSO_TIME_UADDR ((void *) 0x0f000000)
+#define VDSO_PROC_UADDR ((void *) 0x0f001000)
+
+/* The time page. */
+struct vdso_time {
+	uint64_t seq;               /* Odd while an update is in progress. */
+	int64_t ticks;              /* Timer ticks since boot. */
+	uint64_t tick_tsc;          /* TSC value at the last tick. */
+	uint64_t tsc_per_tick;      /* TSC increments per tick, or 0. */
+	uint32_t timer_freq;        /* Ticks per second. */
+};
+
+/* The process page. */
+struct vdso_proc {
+	int32_t pid;                /* Process identifier. */
+};
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+vdso_rdtsc (void) {
+	uint32_t lo, hi;
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+#endif /* lib/vdso.h */
@@ -41,5 +41,7 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_TEXT 0x200                   /* OS: frame is a shared text page. */
+#define PTE_SHM 0x400                    /* OS: frame is in a shm segment. */
 
 #endif /* threads/pte.h */
@@ -0,0 +1,29 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* A cache of fixed-size objects.
+ *
+ * Unlike malloc(), which rounds every request up to a power of 2,
+ * a slab cache packs objects of exactly one size into whole pages,
+ * so frequently allocated kernel structures waste less memory and
+ * are recycled from a private free list. */
+struct slab_cache {
+	const char *name;           /* For debugging. */
+	size_t obj_size;            /* Size of each object in bytes. */
+	size_t objs_per_slab;       /* Number of objects in one page. */
+	struct list free_list;      /* Free objects. */
+	struct lock lock;           /* Protects the members above. */
+	size_t slab_cnt;            /* Pages currently held. */
+	size_t alloc_cnt;           /* Objects currently allocated. */
+};
+
+void slab_cache_init (struct slab_cache *, const char *name, size_t obj_size);
+void *slab_alloc (struct slab_cache *);
+void *slab_zalloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+
+#endif /* threads/slab.h */
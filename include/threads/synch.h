@@ -39,6 +39,24 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock.  Any number of readers may hold it at once,
+ * or one writer.  Waiting writers keep new readers out, so writers
+ * do not starve. */
+struct rwlock {
+	struct lock lock;           /* Protects the members below. */
+	struct condition can_read;  /* Signaled when readers may enter. */
+	struct condition can_write; /* Signaled when a writer may enter. */
+	int readers;                /* Readers holding the lock. */
+	int writers_waiting;        /* Writers waiting for the lock. */
+	bool writer;                /* Held by a writer? */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -6,6 +6,9 @@
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "include/threads/synch.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -108,21 +111,21 @@ struct thread {
 	struct list_elem all_elem;
 
 	struct thread *parent_t;
-	struct list children_list;
-	struct list_elem child_elem;
+	struct list children_list;          /* Records of our children. */
+	struct child_record *record;        /* Our own exit record. */
 
-	struct semaphore sema_exit;
-	struct semaphore sema_wait;
 	struct semaphore sema_fork; 
 	int exit_status;
 
-	struct file **fdt;
-	int next_fd;
 	struct file *running_file;
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
+	struct fd_table fdt;                /* File descriptor table. */
+	struct io_ring *ring;               /* Batched I/O ring, if any. */
+	bool strace;                        /* Trace system calls? */
+	struct list shm_refs;               /* Shared memory opens and maps. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
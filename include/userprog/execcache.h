@@ -0,0 +1,39 @@
+#ifndef USERPROG_EXECCACHE_H
+#define USERPROG_EXECCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct inode;
+
+/* One PT_LOAD segment, already validated and converted to the
+ * arguments of load_segment(). */
+struct exec_segment {
+	uint64_t file_page;         /* Page-aligned file offset. */
+	uint64_t mem_page;          /* Page-aligned user address. */
+	uint32_t read_bytes;        /* Bytes to read from the file. */
+	uint32_t zero_bytes;        /* Bytes to zero after them. */
+	bool writable;
+};
+
+/* The parts of an ELF executable that load() needs. */
+struct exec_image {
+	uint64_t entry;             /* Entry point. */
+	int seg_cnt;                /* Number of elements in SEGS. */
+	struct exec_segment segs[]; /* Loadable segments. */
+};
+
+/* Returns the size of an exec_image with SEG_CNT segments. */
+static inline size_t
+exec_image_size (int seg_cnt) {
+	return sizeof (struct exec_image) + seg_cnt * sizeof (struct exec_segment);
+}
+
+void execcache_init (void);
+struct exec_image *execcache_lookup (struct inode *);
+void execcache_insert (struct inode *, uint64_t generation,
+		const struct exec_image *);
+void execcache_forget (struct inode *);
+
+#endif /* userprog/execcache.h */
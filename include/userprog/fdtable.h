@@ -0,0 +1,46 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct file;
+
+/* Placeholders stored in descriptor slots that refer to the console
+ * rather than to an open file. */
+#define STDIN_FILE ((struct file *) 1)
+#define STDOUT_FILE ((struct file *) 2)
+
+/* Initial and maximum number of descriptor slots per process. */
+#define FDT_INIT_CAP 64
+#define FDT_MAX 4096
+
+/* Per-process file descriptor table.
+ *
+ * FILES grows by doubling, up to FDT_MAX slots.  USED has one bit per
+ * slot, so the lowest free descriptor is found with one ffs() per 64
+ * slots, and fork and exit visit only the descriptors in use. */
+struct fd_table {
+	struct file **files;        /* Slot array, CAP entries. */
+	uint64_t *used;             /* Bitmap of occupied slots. */
+	int cap;                    /* Number of slots allocated. */
+	int cnt;                    /* Number of occupied slots. */
+};
+
+bool fdt_init (struct fd_table *);
+bool fdt_fork (struct fd_table *dst, struct fd_table *src);
+void fdt_destroy (struct fd_table *);
+
+int fdt_alloc (struct fd_table *, struct file *);
+bool fdt_install (struct fd_table *, int fd, struct file *);
+struct file *fdt_get (struct fd_table *, int fd);
+struct file *fdt_remove (struct fd_table *, int fd);
+int fdt_next (struct fd_table *, int fd);
+
+/* Returns true if F is one of the console placeholders. */
+static inline bool
+fdt_is_console (struct file *f) {
+	return f == STDIN_FILE || f == STDOUT_FILE;
+}
+
+#endif /* userprog/fdtable.h */
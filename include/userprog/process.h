@@ -1,17 +1,31 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <stddef.h>
 #include "threads/thread.h"
 
+/* Maximum number of descriptor remappings accepted by spawn(). */
+#define SPAWN_FD_MAX 64
+
+/* Descriptor remapping for process_spawn(): CHILD_FD in the new
+ * process refers to a duplicate of the caller's PARENT_FD. */
+struct spawn_fd {
+	int parent_fd;
+	int child_fd;
+};
+
+void process_table_init (void);
+bool process_add_child (struct thread *child);
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_spawn (const char *cmd_line, const struct spawn_fd *fds,
+		size_t fd_cnt);
 int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
 
 void argument_stack (char **parse, int count, void **esp);
-struct thread *get_child_process (int pid);
-void remove_child_process (struct thread *cp);
+struct child_record *get_child_process (int pid);
 
 #endif /* userprog/process.h */
@@ -0,0 +1,14 @@
+#ifndef USERPROG_RING_H
+#define USERPROG_RING_H
+
+#include <ring.h>
+#include <stdbool.h>
+
+struct thread;
+
+void *ring_setup (unsigned entries);
+int ring_enter (unsigned to_submit);
+bool ring_is_page (struct thread *, void *va);
+void ring_destroy (struct thread *);
+
+#endif /* userprog/ring.h */
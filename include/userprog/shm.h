@@ -0,0 +1,22 @@
+#ifndef USERPROG_SHM_H
+#define USERPROG_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct thread;
+
+/* Longest segment name, not counting the null terminator. */
+#define SHM_NAME_MAX 15
+
+/* Largest segment, in pages. */
+#define SHM_MAX_PAGES 256
+
+void shm_init (void);
+int shm_open (const char *name, size_t size);
+void *shm_map (int id, void *addr);
+int shm_unmap (void *addr);
+bool shm_fork (struct thread *child, struct thread *parent);
+void shm_destroy (struct thread *);
+
+#endif /* userprog/shm.h */
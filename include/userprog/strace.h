@@ -0,0 +1,30 @@
+#ifndef USERPROG_STRACE_H
+#define USERPROG_STRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* One traced system call.  Only the first STRACE_ARGS arguments are
+ * kept. */
+#define STRACE_ARGS 3
+struct strace_rec {
+	uint64_t tsc;               /* TSC at entry. */
+	int64_t ret;                /* Return value. */
+	uint64_t args[STRACE_ARGS]; /* Arguments. */
+	uint32_t cycles;            /* Duration in TSC cycles, saturated. */
+	int32_t tid;                /* Calling thread. */
+	uint16_t nr;                /* System call number. */
+	uint16_t argc;              /* Number of arguments of NR. */
+};
+
+/* -strace: Trace every process? */
+extern bool strace_all;
+
+void strace_init (void);
+bool strace_enable (bool enable);
+bool strace_active (void);
+void strace_record (int nr, const uint64_t *args, int argc, uint64_t ret,
+		uint64_t tsc, uint64_t cycles);
+void strace_dump (void);
+
+#endif /* userprog/strace.h */
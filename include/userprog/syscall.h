@@ -1,18 +1,26 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <iovec.h>
 #include <stdbool.h>
+#include "filesys/off_t.h"
 #include "threads/thread.h"
+#include "userprog/process.h"
 
-struct lock filesys_lock;
+/* Maximum number of system call arguments. */
+#define SYSCALL_MAX_ARGS 6
 
 void syscall_init (void);
+void syscall_print_stats (void);
+const char *syscall_name (int nr);
+void check_address (const void *addr);
 
 void halt (void);
 void exit (int status);
 int fork (const char *thread_name);
 int exec (const char *file_name);
 int wait (tid_t pid);
+int spawn (const char *cmd_line, const struct spawn_fd *fds, unsigned fd_cnt);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
 int open (const char *file);
@@ -22,5 +30,15 @@ int write (int fd, const void *buffer, unsigned size);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
+int dup2 (int oldfd, int newfd);
+int pipe (int *fds);
+int pread (int fd, void *buffer, unsigned size, off_t ofs);
+int pwrite (int fd, const void *buffer, unsigned size, off_t ofs);
+int readv (int fd, const struct iovec *iov, int iov_cnt);
+int writev (int fd, const struct iovec *iov, int iov_cnt);
+int copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+		unsigned length);
+int fsync (int fd);
+int ttymode (int mode);
 
 #endif /* userprog/syscall.h */
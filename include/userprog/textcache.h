@@ -0,0 +1,17 @@
+#ifndef USERPROG_TEXTCACHE_H
+#define USERPROG_TEXTCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct file;
+
+void textcache_init (void);
+bool textcache_map (uint64_t *pml4, void *upage, struct file *file,
+		off_t ofs, size_t read_bytes);
+bool textcache_fork (uint64_t *pml4, void *upage, uint64_t *parent_pte);
+void textcache_unmap_all (uint64_t *pml4);
+
+#endif /* userprog/textcache.h */
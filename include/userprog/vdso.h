@@ -0,0 +1,16 @@
+#ifndef USERPROG_VDSO_H
+#define USERPROG_VDSO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vdso.h>
+
+struct thread;
+
+void vdso_init (void);
+void vdso_update (int64_t ticks);
+bool vdso_map (struct thread *);
+void vdso_unmap (uint64_t *pml4);
+bool vdso_is_page (void *va);
+
+#endif /* userprog/vdso.h */
@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -145,6 +145,78 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+pid_t
+spawn (const char *cmd_line, const struct spawn_fd *fds, size_t fd_cnt) {
+	return (pid_t) syscall3 (SYS_SPAWN, cmd_line, fds, fd_cnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iov_cnt) {
+	return syscall3 (SYS_READV, fd, iov, iov_cnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iov_cnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iov_cnt);
+}
+
+int
+copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+		unsigned length) {
+	return syscall5 (SYS_COPY_FILE_RANGE, fd_in, off_in, fd_out, off_out,
+			length);
+}
+
+struct ring *
+ring_setup (unsigned entries) {
+	return (struct ring *) syscall1 (SYS_RING_SETUP, entries);
+}
+
+int
+ring_enter (unsigned to_submit) {
+	return syscall1 (SYS_RING_ENTER, to_submit);
+}
+
+bool
+strace (bool enable) {
+	return syscall1 (SYS_STRACE, enable);
+}
+
+int
+ttymode (int mode) {
+	return syscall1 (SYS_TTYMODE, mode);
+}
+
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
+int
+shm_open (const char *name, size_t size) {
+	return syscall2 (SYS_SHM_OPEN, name, size);
+}
+
+void *
+shm_map (int id, void *addr) {
+	return (void *) syscall2 (SYS_SHM_MAP, id, addr);
+}
+
+int
+shm_unmap (void *addr) {
+	return syscall1 (SYS_SHM_UNMAP, addr);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
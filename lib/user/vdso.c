@@ -0,0 +1,58 @@
+#include <syscall.h>
+#include <vdso.h>
+
+#define barrier() asm volatile ("" : : : "memory")
+
+static volatile const struct vdso_time *const time_page = VDSO_TIME_UADDR;
+static volatile const struct vdso_proc *const proc_page = VDSO_PROC_UADDR;
+
+/* Takes a consistent snapshot of the time page into *T, together with
+   the TSC value at the time of the snapshot. */
+static uint64_t
+read_time (struct vdso_time *t) {
+	uint64_t seq, tsc;
+
+	do {
+		while ((seq = time_page->seq) & 1)
+			continue;
+		barrier ();
+		t->ticks = time_page->ticks;
+		t->tick_tsc = time_page->tick_tsc;
+		t->tsc_per_tick = time_page->tsc_per_tick;
+		t->timer_freq = time_page->timer_freq;
+		tsc = vdso_rdtsc ();
+		barrier ();
+	} while (time_page->seq != seq);
+	return tsc;
+}
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+vdso_ticks (void) {
+	struct vdso_time t;
+	read_time (&t);
+	return t.ticks;
+}
+
+/* Returns the time since the OS booted in nanoseconds.  Between
+   ticks the time is interpolated with the TSC; before the kernel has
+   calibrated the TSC it advances only once per tick. */
+int64_t
+vdso_time_ns (void) {
+	struct vdso_time t;
+	uint64_t tsc = read_time (&t);
+	uint64_t ns_per_tick = 1000000000 / t.timer_freq;
+	uint64_t delta = tsc - t.tick_tsc;
+
+	if (t.tsc_per_tick == 0)
+		return t.ticks * ns_per_tick;
+	if (delta >= t.tsc_per_tick)
+		delta = t.tsc_per_tick - 1;
+	return t.ticks * ns_per_tick + delta * ns_per_tick / t.tsc_per_tick;
+}
+
+/* Returns the calling process's pid. */
+pid_t
+vdso_getpid (void) {
+	return proc_page->pid;
+}
@@ -85,13 +85,8 @@ exec_children (const char *child_name, pid_t pids[], size_t child_cnt)
     {
       char cmd_line[128];
       snprintf (cmd_line, sizeof cmd_line, "%s %zu", child_name, i);
-      if ((pids[i] = fork (child_name))){
-        CHECK (pids[i] != PID_ERROR,
+      CHECK ((pids[i] = spawn (cmd_line, NULL, 0)) != PID_ERROR,
              "exec child %zu of %zu: \"%s\"", i + 1, child_cnt, cmd_line);
-      } else {
-        exec (cmd_line);
-      }
-      
     }
 }
 
@@ -0,0 +1,32 @@
+/* Copies a file inside the kernel with copy_file_range(), first
+   through the file positions and then at explicit offsets. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int size = sizeof sample - 1;
+  off_t in_ofs = 100, out_ofs = 100;
+  int in, out;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((out = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  CHECK (copy_file_range (in, NULL, out, NULL, 100) == 100,
+         "copy first 100 bytes");
+  CHECK (tell (in) == 100 && tell (out) == 100, "file positions advanced");
+
+  CHECK (copy_file_range (in, &in_ofs, out, &out_ofs, size) == size - 100,
+         "copy the rest at explicit offsets");
+  CHECK (in_ofs == size && out_ofs == size, "offsets advanced");
+  CHECK (tell (in) == 100 && tell (out) == 100, "file positions unchanged");
+  close (in);
+  close (out);
+
+  check_file ("test.txt", sample, size);
+}
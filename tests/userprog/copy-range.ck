@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range) begin
+(copy-range) open "sample.txt"
+(copy-range) create "test.txt"
+(copy-range) open "test.txt"
+(copy-range) copy first 100 bytes
+(copy-range) file positions advanced
+(copy-range) copy the rest at explicit offsets
+(copy-range) offsets advanced
+(copy-range) file positions unchanged
+(copy-range) open "test.txt" for verification
+(copy-range) verified contents of "test.txt"
+(copy-range) close "test.txt"
+(copy-range) end
+copy-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Fills the root directory with enough files that it switches to a
+   hashed index, then checks that lookups and removals still find
+   the right files. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 100
+
+void
+test_main (void) 
+{
+  char name[16];
+  int i, fd;
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!create (name, i))
+        fail ("create \"%s\" failed", name);
+    }
+  msg ("created %d files", FILE_CNT);
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      if (filesize (fd) != i)
+        fail ("\"%s\" has size %d, not %d", name, filesize (fd), i);
+      close (fd);
+    }
+  msg ("opened every file");
+
+  for (i = 0; i < FILE_CNT; i += 2)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      fd = open (name);
+      if ((i % 2 == 0) != (fd < 2))
+        fail ("open \"%s\" returned %d", name, fd);
+      if (fd >= 2)
+        close (fd);
+    }
+  msg ("removed every other file");
+
+  CHECK (create ("f0", 7), "create \"f0\" again");
+  CHECK (!create ("f1", 7), "create \"f1\" again (must fail)");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dir-many) begin
+(dir-many) created 100 files
+(dir-many) opened every file
+(dir-many) removed every other file
+(dir-many) create "f0" again
+(dir-many) create "f1" again (must fail)
+(dir-many) end
+dir-many: exit(0)
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Grows an empty file by writing past its end, in chunks that do
+   not line up with sectors, then reads the whole file back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHUNK 1234
+#define CHUNK_CNT 20
+
+static char buf[CHUNK * CHUNK_CNT];
+
+void
+test_main (void) 
+{
+  static char back[sizeof buf];
+  size_t i;
+  int fd;
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = i * 7 + i / 256;
+
+  CHECK (create ("grow", 0), "create \"grow\"");
+  CHECK ((fd = open ("grow")) > 1, "open \"grow\"");
+  for (i = 0; i < CHUNK_CNT; i++)
+    if (write (fd, buf + i * CHUNK, CHUNK) != CHUNK)
+      fail ("write %zu bytes at offset %zu failed", (size_t) CHUNK,
+            i * CHUNK);
+  msg ("wrote %zu bytes", sizeof buf);
+  CHECK (filesize (fd) == (int) sizeof buf, "filesize");
+
+  seek (fd, 0);
+  CHECK (read (fd, back, sizeof back) == (int) sizeof back, "read back");
+  if (memcmp (buf, back, sizeof buf))
+    fail ("data read back differs from data written");
+  msg ("data matches");
+  close (fd);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(grow-file) begin
+(grow-file) create "grow"
+(grow-file) open "grow"
+(grow-file) wrote 24680 bytes
+(grow-file) filesize
+(grow-file) read back
+(grow-file) data matches
+(grow-file) end
+grow-file: exit(0)
+EOF
+pass;
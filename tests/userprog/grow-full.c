@@ -0,0 +1,36 @@
+/* Tries to grow a file far past the size of the disk, which must
+   fail without changing the file, then checks that the space the
+   failed write took was given back by writing another file. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FAR_OFFSET (64 * 1024 * 1024)
+
+static char buf[20000];
+
+void
+test_main (void) 
+{
+  char byte = 'x';
+  int fd, i;
+
+  CHECK (create ("huge", 0), "create \"huge\"");
+  CHECK ((fd = open ("huge")) > 1, "open \"huge\"");
+  for (i = 0; i < 3; i++)
+    {
+      seek (fd, FAR_OFFSET);
+      if (write (fd, &byte, 1) != 0)
+        fail ("write past the end of the disk succeeded");
+    }
+  msg ("write past the end of the disk failed");
+  CHECK (filesize (fd) == 0, "filesize is still 0");
+  close (fd);
+
+  CHECK (create ("after", 0), "create \"after\"");
+  CHECK ((fd = open ("after")) > 1, "open \"after\"");
+  CHECK (write (fd, buf, sizeof buf) == (int) sizeof buf,
+         "write %zu bytes", sizeof buf);
+  close (fd);
+}
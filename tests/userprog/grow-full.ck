@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(grow-full) begin
+(grow-full) create "huge"
+(grow-full) open "huge"
+(grow-full) write past the end of the disk failed
+(grow-full) filesize is still 0
+(grow-full) create "after"
+(grow-full) open "after"
+(grow-full) write 20000 bytes
+(grow-full) end
+grow-full: exit(0)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Redirects a child's standard output into a pipe with dup2(), as a
+   shell pipeline would, and reads it back in the parent. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  const char *expected = "(pipe-dup2) hello through a pipe\n";
+  char buf[128];
+  int fds[2];
+  int pid, total, n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      dup2 (fds[1], STDOUT_FILENO);
+      close (fds[0]);
+      close (fds[1]);
+      msg ("hello through a pipe");
+      exit (0);
+    }
+
+  close (fds[1]);
+  total = 0;
+  while ((n = read (fds[0], buf + total, sizeof buf - 1 - total)) > 0)
+    total += n;
+  buf[total] = '\0';
+  CHECK (wait (pid) == 0, "wait for child");
+  if (strcmp (buf, expected))
+    fail ("read \"%s\" from pipe", buf);
+  msg ("child's output came through the pipe");
+  close (fds[0]);
+}
@@ -0,0 +1,45 @@
+/* Streams more than a pipe's worth of data from a forked child to
+   its parent, then checks that the parent sees end of file once the
+   child's write end is gone. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE 10000
+
+static char buf[DATA_SIZE + 1];
+
+void
+test_main (void) 
+{
+  int fds[2];
+  int pid, total, n, i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      for (i = 0; i < DATA_SIZE; i++)
+        buf[i] = i % 251;
+      for (i = 0; i < DATA_SIZE; i += 1000)
+        if (write (fds[1], buf + i, 1000) != 1000)
+          exit (1);
+      exit (0);
+    }
+
+  close (fds[1]);
+  total = 0;
+  while ((n = read (fds[0], buf + total, DATA_SIZE + 1 - total)) > 0)
+    total += n;
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (total == DATA_SIZE, "read %d bytes", DATA_SIZE);
+  for (i = 0; i < DATA_SIZE; i++)
+    if (buf[i] != (char) (i % 251))
+      fail ("byte %d differs", i);
+  msg ("data matches");
+  CHECK (read (fds[0], buf, 1) == 0, "end of file");
+  close (fds[0]);
+}
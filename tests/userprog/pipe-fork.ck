@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-fork) begin
+(pipe-fork) pipe
+child: exit(0)
+(pipe-fork) wait for child
+(pipe-fork) read 10000 bytes
+(pipe-fork) data matches
+(pipe-fork) end of file
+(pipe-fork) end
+pipe-fork: exit(0)
+EOF
+pass;
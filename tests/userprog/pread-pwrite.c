@@ -0,0 +1,33 @@
+/* Reads and writes at explicit offsets with pread() and pwrite()
+   and checks that neither moves the file position. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t half = (sizeof sample - 1) / 2;
+  char buf[sizeof sample];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (pread (handle, buf, 20, 100) == 20, "pread 20 bytes at offset 100");
+  compare_bytes (buf, sample + 100, 20, 100, "sample.txt");
+  CHECK (tell (handle) == 0, "file position unchanged");
+  CHECK (read (handle, buf, 10) == 10, "read 10 bytes");
+  compare_bytes (buf, sample, 10, 0, "sample.txt");
+  close (handle);
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (pwrite (handle, sample + half, sizeof sample - 1 - half, half)
+         == (int) (sizeof sample - 1 - half), "pwrite second half");
+  CHECK (pwrite (handle, sample, half, 0) == (int) half, "pwrite first half");
+  CHECK (tell (handle) == 0, "file position unchanged");
+  close (handle);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
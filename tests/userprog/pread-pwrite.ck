@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) open "sample.txt"
+(pread-pwrite) pread 20 bytes at offset 100
+(pread-pwrite) file position unchanged
+(pread-pwrite) read 10 bytes
+(pread-pwrite) create "test.txt"
+(pread-pwrite) open "test.txt"
+(pread-pwrite) pwrite second half
+(pread-pwrite) pwrite first half
+(pread-pwrite) file position unchanged
+(pread-pwrite) open "test.txt" for verification
+(pread-pwrite) verified contents of "test.txt"
+(pread-pwrite) close "test.txt"
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Gathers a file from several buffers with writev() and scatters
+   it back into buffers of different sizes with readv(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  char a[7], b[300], c[sizeof sample];
+  char copy[sizeof sample];
+  struct iovec iov[3];
+  int handle;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  iov[0].iov_base = (void *) sample;
+  iov[0].iov_len = 13;
+  iov[1].iov_base = (void *) (sample + 13);
+  iov[1].iov_len = 0;
+  iov[2].iov_base = (void *) (sample + 13);
+  iov[2].iov_len = size - 13;
+  CHECK (writev (handle, iov, 3) == (int) size, "writev 3 buffers");
+  CHECK (tell (handle) == size, "file position advanced");
+  close (handle);
+  check_file ("test.txt", sample, size);
+
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  iov[0].iov_base = a;
+  iov[0].iov_len = sizeof a;
+  iov[1].iov_base = b;
+  iov[1].iov_len = sizeof b;
+  iov[2].iov_base = c;
+  iov[2].iov_len = sizeof c;
+  CHECK (readv (handle, iov, 3) == (int) size, "readv 3 buffers");
+  memcpy (copy, a, sizeof a);
+  memcpy (copy + sizeof a, b, sizeof b);
+  memcpy (copy + sizeof a + sizeof b, c, size - sizeof a - sizeof b);
+  compare_bytes (copy, sample, size, 0, "test.txt");
+  close (handle);
+}
@@ -0,0 +1,65 @@
+/* Opens, reads and closes a file through a submission ring, with
+   several operations completed by a single ring_enter(). */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring *ring;
+
+static void
+submit (enum ring_op op, int fd, void *addr, unsigned len, int64_t off,
+        uint64_t user_data)
+{
+  struct ring_sqe *sqe = &ring->sqes[ring->sq_tail % ring->sq_entries];
+
+  sqe->opcode = op;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t) addr;
+  sqe->len = len;
+  sqe->off = off;
+  sqe->user_data = user_data;
+  ring->sq_tail++;
+}
+
+static struct ring_cqe *
+complete (void)
+{
+  if (ring->cq_head == ring->cq_tail)
+    fail ("completion queue empty");
+  return &ring->cqes[ring->cq_head++ % ring->cq_entries];
+}
+
+void
+test_main (void) 
+{
+  char buf1[20], buf2[10];
+  struct ring_cqe *cqe;
+  int fd;
+
+  CHECK ((ring = ring_setup (8)) != NULL, "ring_setup");
+
+  submit (RING_OP_OPEN, 0, "sample.txt", 0, 0, 1);
+  CHECK (ring_enter (1) == 1, "submit open");
+  cqe = complete ();
+  CHECK (cqe->user_data == 1 && (fd = cqe->res) > 1, "open \"sample.txt\"");
+
+  submit (RING_OP_PREAD, fd, buf1, sizeof buf1, 100, 2);
+  submit (RING_OP_READ, fd, buf2, sizeof buf2, 0, 3);
+  submit (RING_OP_FSYNC, fd, NULL, 0, 0, 4);
+  submit (RING_OP_CLOSE, fd, NULL, 0, 0, 5);
+  CHECK (ring_enter (4) == 4, "submit pread, read, fsync and close");
+
+  cqe = complete ();
+  CHECK (cqe->user_data == 2 && cqe->res == sizeof buf1, "pread completed");
+  compare_bytes (buf1, sample + 100, sizeof buf1, 100, "sample.txt");
+  cqe = complete ();
+  CHECK (cqe->user_data == 3 && cqe->res == sizeof buf2, "read completed");
+  compare_bytes (buf2, sample, sizeof buf2, 0, "sample.txt");
+  cqe = complete ();
+  CHECK (cqe->user_data == 4 && cqe->res == 0, "fsync completed");
+  cqe = complete ();
+  CHECK (cqe->user_data == 5 && cqe->res == 0, "close completed");
+  CHECK (ring->cq_head == ring->cq_tail, "no more completions");
+}
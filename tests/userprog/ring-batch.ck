@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-batch) begin
+(ring-batch) ring_setup
+(ring-batch) submit open
+(ring-batch) open "sample.txt"
+(ring-batch) submit pread, read, fsync and close
+(ring-batch) pread completed
+(ring-batch) read completed
+(ring-batch) fsync completed
+(ring-batch) close completed
+(ring-batch) no more completions
+(ring-batch) end
+ring-batch: exit(0)
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Shares a memory segment between a process and its forked child,
+   once through the inherited mapping and once through a new mapping
+   of the segment by name. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SEG_SIZE 8192
+#define ADDR1 ((char *) 0x20000000)
+#define ADDR2 ((char *) 0x30000000)
+
+void
+test_main (void) 
+{
+  int id, pid, i;
+
+  CHECK ((id = shm_open ("shm-share", SEG_SIZE)) >= 0, "shm_open");
+  CHECK (shm_map (id, ADDR1) == ADDR1, "shm_map");
+  for (i = 0; i < SEG_SIZE; i++)
+    if (ADDR1[i] != 0)
+      fail ("segment not zeroed at byte %d", i);
+
+  /* The child writes through its inherited mapping... */
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      for (i = 0; i < SEG_SIZE; i++)
+        ADDR1[i] = i % 97;
+      exit (0);
+    }
+  CHECK (wait (pid) == 0, "wait for first child");
+  for (i = 0; i < SEG_SIZE; i++)
+    if (ADDR1[i] != i % 97)
+      fail ("byte %d differs after first child", i);
+  msg ("saw first child's writes");
+
+  /* ...and through a second mapping it makes itself. */
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      int cid = shm_open ("shm-share", 0);
+      if (cid != id || shm_map (cid, ADDR2) != ADDR2)
+        exit (1);
+      for (i = 0; i < SEG_SIZE; i++)
+        ADDR2[i] = i % 89;
+      exit (0);
+    }
+  CHECK (wait (pid) == 0, "wait for second child");
+  for (i = 0; i < SEG_SIZE; i++)
+    if (ADDR1[i] != i % 89)
+      fail ("byte %d differs after second child", i);
+  msg ("saw second child's writes");
+
+  CHECK (shm_unmap (ADDR1) == 0, "shm_unmap");
+  CHECK (shm_unmap (ADDR1) == -1, "shm_unmap again fails");
+}
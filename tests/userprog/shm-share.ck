@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-share) begin
+(shm-share) shm_open
+(shm-share) shm_map
+child: exit(0)
+(shm-share) wait for first child
+(shm-share) saw first child's writes
+child: exit(0)
+(shm-share) wait for second child
+(shm-share) saw second child's writes
+(shm-share) shm_unmap
+(shm-share) shm_unmap again fails
+(shm-share) end
+shm-share: exit(0)
+EOF
+pass;
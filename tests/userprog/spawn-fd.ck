@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-fd) begin
+(spawn-fd) open "sample.txt"
+(spawn-fd) read "sample.txt" first 20 bytes
+(spawn-fd) spawn "child-read"
+(child-read) begin
+(child-read) open "sample.txt"
+(child-read) read "sample.txt" first 20 bytes
+(child-read) read "sample.txt" remainders
+(child-read) Child success
+(child-read) end
+child-read: exit(0)
+(spawn-fd) Parent success
+(spawn-fd) end
+spawn-fd: exit(0)
+EOF
+pass;
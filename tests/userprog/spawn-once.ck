@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-once) begin
+(spawn-once) I'm your father
+(spawn-once) spawn("child-simple")
+(child-simple) run
+child-simple: exit(81)
+(spawn-once) wait(spawn()) = 81
+(spawn-once) end
+spawn-once: exit(0)
+EOF
+pass;
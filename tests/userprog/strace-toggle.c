@@ -0,0 +1,23 @@
+/* Turns system call tracing on and off, and checks that a forked
+   child inherits the setting. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int pid;
+
+  CHECK (!strace (true), "enable tracing");
+  msg ("traced call");
+
+  pid = fork ("child");
+  if (pid == 0)
+    exit (strace (false) ? 81 : 82);
+  CHECK (wait (pid) == 81, "child inherited tracing");
+
+  CHECK (strace (false), "disable tracing");
+  CHECK (!strace (false), "tracing stays off");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(strace-toggle) begin
+(strace-toggle) enable tracing
+(strace-toggle) traced call
+child: exit(81)
+(strace-toggle) child inherited tracing
+(strace-toggle) disable tracing
+(strace-toggle) tracing stays off
+(strace-toggle) end
+strace-toggle: exit(0)
+EOF
+pass;
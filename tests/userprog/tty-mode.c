@@ -0,0 +1,15 @@
+/* Switches the console between raw and canonical input, and tries
+   an invalid mode. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  CHECK (ttymode (TTY_CANON) == TTY_RAW, "raw by default");
+  CHECK (ttymode (TTY_RAW) == TTY_CANON, "switched to canonical");
+  CHECK (ttymode (42) == -1, "invalid mode rejected");
+  CHECK (ttymode (TTY_RAW) == TTY_RAW, "still raw");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(tty-mode) begin
+(tty-mode) raw by default
+(tty-mode) switched to canonical
+(tty-mode) invalid mode rejected
+(tty-mode) still raw
+(tty-mode) end
+tty-mode: exit(0)
+EOF
+pass;
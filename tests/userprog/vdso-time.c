@@ -0,0 +1,33 @@
+/* Reads the time and the pid from the kernel data pages, checking
+   that time never runs backward and that a forked child sees its own
+   pid. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int64_t start = vdso_ticks ();
+  int64_t prev_ns = vdso_time_ns ();
+  int pid;
+
+  /* Spin until the next tick, watching the clock. */
+  while (vdso_ticks () == start)
+    {
+      int64_t ns = vdso_time_ns ();
+      if (ns < prev_ns)
+        fail ("time ran backward");
+      prev_ns = ns;
+    }
+  msg ("ticks advanced");
+  if (vdso_time_ns () < prev_ns)
+    fail ("time ran backward across a tick");
+
+  pid = fork ("child");
+  if (pid == 0)
+    exit (vdso_getpid ());
+  CHECK (wait (pid) == pid, "child saw its own pid");
+  CHECK (vdso_getpid () != pid, "parent's pid differs");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(vdso-time) begin
+(vdso-time) ticks advanced
+(vdso-time) child saw its own pid
+(vdso-time) parent's pid differs
+(vdso-time) end
+vdso-time: exit(0)
+EOF
+pass;
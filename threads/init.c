@@ -23,8 +23,13 @@
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/textcache.h"
+#include "userprog/execcache.h"
+#include "userprog/vdso.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
+#include "userprog/shm.h"
+#include "userprog/strace.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #endif
@@ -34,6 +39,8 @@
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
+#include "filesys/cache.h"
+#include "filesys/dcache.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
@@ -100,6 +107,12 @@ main (void) {
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	process_table_init ();
+	textcache_init ();
+	execcache_init ();
+	vdso_init ();
+	strace_init ();
+	shm_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
@@ -216,6 +229,8 @@ parse_options (char **argv) {
 #ifdef FILESYS
 		else if (!strcmp (name, "-f"))
 			format_filesys = true;
+		else if (!strcmp (name, "-bc"))
+			cache_size = atoi (value);
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
@@ -226,6 +241,8 @@ parse_options (char **argv) {
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+		else if (!strcmp (name, "-strace"))
+			strace_all = true;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -268,6 +285,7 @@ run_actions (char **argv) {
 		{"run", 2, run_task},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
+		{"df", 1, fsutil_df},
 		{"cat", 2, fsutil_cat},
 		{"rm", 2, fsutil_rm},
 		{"put", 2, fsutil_put},
@@ -314,6 +332,7 @@ usage (void) {
 #endif
 #ifdef FILESYS
 			"  ls                 List files in the root directory.\n"
+			"  df                 Report free space fragmentation.\n"
 			"  cat FILE           Print FILE to the console.\n"
 			"  rm FILE            Delete FILE.\n"
 			"Use these actions indirectly via `pintos' -g and -p options:\n"
@@ -328,6 +347,10 @@ usage (void) {
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+			"  -strace            Trace all system calls; dump at power off.\n"
+#endif
+#ifdef FILESYS
+			"  -bc=COUNT          Cache COUNT disk sectors (default 64).\n"
 #endif
 			);
 	power_off ();
@@ -356,10 +379,14 @@ print_stats (void) {
 	thread_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
+	cache_print_stats ();
+	dcache_print_stats ();
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
+	syscall_print_stats ();
+	strace_dump ();
 #endif
 }
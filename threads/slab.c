@@ -0,0 +1,157 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab cache hands out objects carved from whole pages.
+
+   Each page ("slab") starts with a small header followed by as many
+   objects as fit.  Free objects are threaded onto the cache's free
+   list through a list_elem stored in the object itself, so objects
+   must be at least that large.  When every object of a slab is free
+   again, the slab's objects are pulled off the free list and the page
+   goes back to the page allocator, as malloc() does with arenas. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Slab header, at the start of every page owned by a cache. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct slab_cache *cache;   /* Owning cache. */
+	size_t free_cnt;            /* Free objects in this slab. */
+};
+
+/* Free object. */
+struct slab_obj {
+	struct list_elem free_elem; /* Free list element. */
+};
+
+#define SLAB_HDR_SIZE ROUND_UP (sizeof (struct slab), 16)
+
+static struct slab *obj_to_slab (void *);
+static struct slab_obj *slab_to_obj (struct slab_cache *, struct slab *,
+		size_t idx);
+
+/* Initializes CACHE to hand out objects of OBJ_SIZE bytes. */
+void
+slab_cache_init (struct slab_cache *cache, const char *name,
+		size_t obj_size) {
+	ASSERT (obj_size > 0);
+
+	if (obj_size < sizeof (struct slab_obj))
+		obj_size = sizeof (struct slab_obj);
+	obj_size = ROUND_UP (obj_size, sizeof (void *));
+	ASSERT (obj_size <= PGSIZE - SLAB_HDR_SIZE);
+
+	cache->name = name;
+	cache->obj_size = obj_size;
+	cache->objs_per_slab = (PGSIZE - SLAB_HDR_SIZE) / obj_size;
+	list_init (&cache->free_list);
+	lock_init (&cache->lock);
+	cache->slab_cnt = 0;
+	cache->alloc_cnt = 0;
+}
+
+/* Obtains and returns an object from CACHE.
+ * Returns a null pointer if memory is not available. */
+void *
+slab_alloc (struct slab_cache *cache) {
+	struct slab_obj *o;
+
+	lock_acquire (&cache->lock);
+
+	/* If the free list is empty, carve up a new slab. */
+	if (list_empty (&cache->free_list)) {
+		struct slab *s = palloc_get_page (0);
+		size_t i;
+
+		if (s == NULL) {
+			lock_release (&cache->lock);
+			return NULL;
+		}
+
+		s->magic = SLAB_MAGIC;
+		s->cache = cache;
+		s->free_cnt = cache->objs_per_slab;
+		for (i = 0; i < cache->objs_per_slab; i++) {
+			o = slab_to_obj (cache, s, i);
+			list_push_back (&cache->free_list, &o->free_elem);
+		}
+		cache->slab_cnt++;
+	}
+
+	o = list_entry (list_pop_front (&cache->free_list), struct slab_obj,
+			free_elem);
+	obj_to_slab (o)->free_cnt--;
+	cache->alloc_cnt++;
+	lock_release (&cache->lock);
+	return o;
+}
+
+/* Like slab_alloc(), but zeroes the object. */
+void *
+slab_zalloc (struct slab_cache *cache) {
+	void *p = slab_alloc (cache);
+	if (p != NULL)
+		memset (p, 0, cache->obj_size);
+	return p;
+}
+
+/* Returns object P, which must have come from CACHE, to CACHE.
+ * A null pointer is ignored. */
+void
+slab_free (struct slab_cache *cache, void *p) {
+	struct slab_obj *o = p;
+	struct slab *s;
+
+	if (p == NULL)
+		return;
+
+	s = obj_to_slab (p);
+	ASSERT (s->cache == cache);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs. */
+	memset (o, 0xcc, cache->obj_size);
+#endif
+
+	lock_acquire (&cache->lock);
+	list_push_front (&cache->free_list, &o->free_elem);
+	cache->alloc_cnt--;
+
+	/* If the slab is now entirely free, release it. */
+	if (++s->free_cnt >= cache->objs_per_slab) {
+		size_t i;
+
+		ASSERT (s->free_cnt == cache->objs_per_slab);
+		for (i = 0; i < cache->objs_per_slab; i++)
+			list_remove (&slab_to_obj (cache, s, i)->free_elem);
+		cache->slab_cnt--;
+		palloc_free_page (s);
+	}
+	lock_release (&cache->lock);
+}
+
+/* Returns the slab that object P belongs to. */
+static struct slab *
+obj_to_slab (void *p) {
+	struct slab *s = pg_round_down (p);
+
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	return s;
+}
+
+/* Returns the IDX'th object in slab S of CACHE. */
+static struct slab_obj *
+slab_to_obj (struct slab_cache *cache, struct slab *s, size_t idx) {
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (idx < cache->objs_per_slab);
+	return (struct slab_obj *) ((uint8_t *) s + SLAB_HDR_SIZE
+			+ idx * cache->obj_size);
+}
@@ -342,6 +342,65 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 		cond_signal (cond, lock);
 }
 
+/* Initializes RW as unheld. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	cond_init (&rw->can_read);
+	cond_init (&rw->can_write);
+	rw->readers = 0;
+	rw->writers_waiting = 0;
+	rw->writer = false;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or is
+ * waiting for it. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	while (rw->writer || rw->writers_waiting > 0)
+		cond_wait (&rw->can_read, &rw->lock);
+	rw->readers++;
+	lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0)
+		cond_signal (&rw->can_write, &rw->lock);
+	lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no one else holds it. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	rw->writers_waiting++;
+	while (rw->writer || rw->readers > 0)
+		cond_wait (&rw->can_write, &rw->lock);
+	rw->writers_waiting--;
+	rw->writer = true;
+	lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	lock_acquire (&rw->lock);
+	ASSERT (rw->writer);
+	rw->writer = false;
+	if (rw->writers_waiting > 0)
+		cond_signal (&rw->can_write, &rw->lock);
+	else
+		cond_broadcast (&rw->can_read, &rw->lock);
+	lock_release (&rw->lock);
+}
+
 bool
 sema_compare_priority (const struct list_elem *higher, const struct list_elem *lower, void *aux UNUSED) {
 	struct semaphore_elem *higher_sema = list_entry (higher, struct semaphore_elem, elem);
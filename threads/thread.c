@@ -223,19 +223,16 @@ thread_create (const char *name, int priority,
 	list_push_back (&all_list, &t->all_elem);
 
 	t->parent_t = thread_current ();
-	sema_init (&t->sema_exit, 0);
-	sema_init (&t->sema_wait, 0);
 	sema_init (&t->sema_fork, 0);
 
-	list_push_back (&thread_current ()->children_list, &t->child_elem);
-
-	t->fdt = palloc_get_page (PAL_ZERO);
-	if (t->fdt == NULL)
+#ifdef USERPROG
+	if (!fdt_init (&t->fdt) || !process_add_child (t)) {
+		list_remove (&t->all_elem);
+		fdt_destroy (&t->fdt);
+		palloc_free_page (t);
 		return TID_ERROR;
-
-	t->fdt[0] = 1;
-	t->fdt[1] = 2;
-	t->next_fd = 2;
+	}
+#endif
 
 	thread_unblock (t);
 	preemption_priority ();
@@ -486,6 +483,9 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->recent_cpu = RECENT_CPU_DEFAULT;
 
 	list_init (&t->children_list);
+#ifdef USERPROG
+	list_init (&t->shm_refs);
+#endif
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -0,0 +1,149 @@
+#include "userprog/execcache.h"
+#include <debug.h>
+#include <list.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Parsed ELF headers of recently executed programs.
+
+   load() reads and validates the ELF header and every program header
+   on each exec.  Programs that are executed over and over skip that by
+   finding their segment list here.  An entry records the executable's
+   inode generation when it was parsed and is only used while the
+   generation is unchanged, that is, until the file is written.
+
+   Each entry keeps its inode open, so the in-memory inode and its
+   generation survive between execs.  The cache is small and evicts the
+   least recently used entry, which also closes its inode.  Removing
+   an executable drops its entry at once, so that its sectors are not
+   held until eviction. */
+
+/* Maximum number of cached executables. */
+#define EXEC_CACHE_SIZE 16
+
+struct exec_entry {
+	struct list_elem elem;      /* Element in exec_cache. */
+	struct inode *inode;        /* Executable, held open. */
+	uint64_t generation;        /* INODE's generation when parsed. */
+	struct exec_image *image;   /* Parsed headers. */
+};
+
+static struct list exec_cache;  /* Most recently used first. */
+static int exec_cache_cnt;
+static struct lock exec_lock;   /* Protects the members above. */
+
+static void entry_free (struct exec_entry *);
+
+/* Initializes the exec cache. */
+void
+execcache_init (void) {
+	list_init (&exec_cache);
+	exec_cache_cnt = 0;
+	lock_init (&exec_lock);
+}
+
+/* Looks up the parsed headers of the executable in INODE.  Returns a
+ * copy, which the caller must free(), or a null pointer if INODE is
+ * not cached or has been written since it was parsed. */
+struct exec_image *
+execcache_lookup (struct inode *inode) {
+	struct exec_image *image = NULL;
+	struct list_elem *e;
+
+	lock_acquire (&exec_lock);
+	for (e = list_begin (&exec_cache); e != list_end (&exec_cache);
+			e = list_next (e)) {
+		struct exec_entry *ent = list_entry (e, struct exec_entry, elem);
+		if (ent->inode != inode)
+			continue;
+
+		if (ent->generation != inode_get_generation (inode)) {
+			/* Stale. */
+			list_remove (&ent->elem);
+			entry_free (ent);
+			break;
+		}
+
+		image = malloc (exec_image_size (ent->image->seg_cnt));
+		if (image != NULL) {
+			memcpy (image, ent->image, exec_image_size (ent->image->seg_cnt));
+			list_remove (&ent->elem);
+			list_push_front (&exec_cache, &ent->elem);
+		}
+		break;
+	}
+	lock_release (&exec_lock);
+	return image;
+}
+
+/* Caches a copy of IMAGE, parsed from INODE while INODE had the given
+ * GENERATION, replacing any older entry for INODE.  Failure to
+ * allocate memory is not an error; the next exec just parses again. */
+void
+execcache_insert (struct inode *inode, uint64_t generation,
+		const struct exec_image *image) {
+	struct exec_entry *ent;
+	struct list_elem *e;
+
+	if (generation != inode_get_generation (inode))
+		return;
+
+	ent = malloc (sizeof *ent);
+	if (ent == NULL)
+		return;
+	ent->image = malloc (exec_image_size (image->seg_cnt));
+	if (ent->image == NULL) {
+		free (ent);
+		return;
+	}
+	memcpy (ent->image, image, exec_image_size (image->seg_cnt));
+	ent->inode = inode_reopen (inode);
+	ent->generation = generation;
+
+	lock_acquire (&exec_lock);
+	for (e = list_begin (&exec_cache); e != list_end (&exec_cache);
+			e = list_next (e)) {
+		struct exec_entry *old = list_entry (e, struct exec_entry, elem);
+		if (old->inode == inode) {
+			list_remove (&old->elem);
+			entry_free (old);
+			break;
+		}
+	}
+	if (exec_cache_cnt >= EXEC_CACHE_SIZE)
+		entry_free (list_entry (list_pop_back (&exec_cache),
+					struct exec_entry, elem));
+	list_push_front (&exec_cache, &ent->elem);
+	exec_cache_cnt++;
+	lock_release (&exec_lock);
+}
+
+/* Drops the entry for INODE, if any, closing the cache's reference
+ * to it. */
+void
+execcache_forget (struct inode *inode) {
+	struct list_elem *e;
+
+	lock_acquire (&exec_lock);
+	for (e = list_begin (&exec_cache); e != list_end (&exec_cache);
+			e = list_next (e)) {
+		struct exec_entry *ent = list_entry (e, struct exec_entry, elem);
+		if (ent->inode == inode) {
+			list_remove (&ent->elem);
+			entry_free (ent);
+			break;
+		}
+	}
+	lock_release (&exec_lock);
+}
+
+/* Frees ENT, which has been removed from exec_cache. */
+static void
+entry_free (struct exec_entry *ent) {
+	exec_cache_cnt--;
+	inode_close (ent->inode);
+	free (ent->image);
+	free (ent);
+}
@@ -0,0 +1,219 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+#define WORD_BITS 64
+#define WORD_CNT(CAP) (((CAP) + WORD_BITS - 1) / WORD_BITS)
+
+static bool fdt_grow (struct fd_table *, int min_cap);
+
+static inline bool
+slot_used (const struct fd_table *fdt, int fd) {
+	return (fdt->used[fd / WORD_BITS] >> (fd % WORD_BITS)) & 1;
+}
+
+static inline void
+slot_set (struct fd_table *fdt, int fd, struct file *file) {
+	fdt->files[fd] = file;
+	fdt->used[fd / WORD_BITS] |= (uint64_t) 1 << (fd % WORD_BITS);
+	fdt->cnt++;
+}
+
+static inline void
+slot_clear (struct fd_table *fdt, int fd) {
+	fdt->files[fd] = NULL;
+	fdt->used[fd / WORD_BITS] &= ~((uint64_t) 1 << (fd % WORD_BITS));
+	fdt->cnt--;
+}
+
+/* Initializes FDT with FDT_INIT_CAP slots, of which 0 and 1 are
+ * the console.  Returns false if memory allocation fails. */
+bool
+fdt_init (struct fd_table *fdt) {
+	fdt->files = NULL;
+	fdt->used = NULL;
+	fdt->cap = 0;
+	fdt->cnt = 0;
+	if (!fdt_grow (fdt, FDT_INIT_CAP))
+		return false;
+
+	slot_set (fdt, 0, STDIN_FILE);
+	slot_set (fdt, 1, STDOUT_FILE);
+	return true;
+}
+
+/* Makes room for at least MIN_CAP slots in FDT. */
+static bool
+fdt_grow (struct fd_table *fdt, int min_cap) {
+	struct file **files;
+	uint64_t *used;
+	int cap = fdt->cap > 0 ? fdt->cap : FDT_INIT_CAP;
+
+	if (min_cap > FDT_MAX)
+		return false;
+	while (cap < min_cap)
+		cap *= 2;
+	if (cap > FDT_MAX)
+		cap = FDT_MAX;
+	if (cap <= fdt->cap)
+		return true;
+
+	files = realloc (fdt->files, cap * sizeof *files);
+	if (files == NULL)
+		return false;
+	fdt->files = files;
+	memset (files + fdt->cap, 0, (cap - fdt->cap) * sizeof *files);
+
+	used = realloc (fdt->used, WORD_CNT (cap) * sizeof *used);
+	if (used == NULL)
+		return false;
+	fdt->used = used;
+	memset (used + WORD_CNT (fdt->cap), 0,
+			(WORD_CNT (cap) - WORD_CNT (fdt->cap)) * sizeof *used);
+
+	fdt->cap = cap;
+	return true;
+}
+
+/* Returns the lowest occupied descriptor at or above FD in FDT, or -1
+ * if there is none.  Use it to visit the open descriptors only:
+ *   for (fd = fdt_next (fdt, 0); fd >= 0; fd = fdt_next (fdt, fd + 1)) */
+int
+fdt_next (struct fd_table *fdt, int fd) {
+	if (fd < 0)
+		fd = 0;
+	for (int w = fd / WORD_BITS; w < WORD_CNT (fdt->cap); w++) {
+		uint64_t word = fdt->used[w];
+		if (w == fd / WORD_BITS)
+			word &= ~(uint64_t) 0 << (fd % WORD_BITS);
+		if (word != 0)
+			return w * WORD_BITS + __builtin_ffsll (word) - 1;
+	}
+	return -1;
+}
+
+/* Stores FILE in the lowest free descriptor of FDT, growing the table
+ * if every slot is taken.  Returns the descriptor, or -1 if FDT is
+ * full.  FDT takes over the caller's reference to FILE. */
+int
+fdt_alloc (struct fd_table *fdt, struct file *file) {
+	int fd;
+
+	ASSERT (file != NULL);
+
+	for (int w = 0; w < WORD_CNT (fdt->cap); w++)
+		if (~fdt->used[w] != 0) {
+			fd = w * WORD_BITS + __builtin_ffsll (~fdt->used[w]) - 1;
+			if (fd < fdt->cap) {
+				slot_set (fdt, fd, file);
+				return fd;
+			}
+		}
+
+	fd = fdt->cap;
+	if (!fdt_grow (fdt, fd + 1))
+		return -1;
+	slot_set (fdt, fd, file);
+	return fd;
+}
+
+/* Stores FILE in descriptor FD of FDT, closing whatever FD referred to
+ * before.  FDT takes over the caller's reference to FILE.  Returns
+ * false if FD is out of range or the table cannot grow. */
+bool
+fdt_install (struct fd_table *fdt, int fd, struct file *file) {
+	ASSERT (file != NULL);
+
+	if (fd < 0 || (fd >= fdt->cap && !fdt_grow (fdt, fd + 1)))
+		return false;
+
+	if (slot_used (fdt, fd)) {
+		struct file *old = fdt->files[fd];
+		slot_clear (fdt, fd);
+		if (!fdt_is_console (old))
+			file_close (old);
+	}
+	slot_set (fdt, fd, file);
+	return true;
+}
+
+/* Returns the file behind descriptor FD of FDT, or a null pointer if
+ * FD is not open. */
+struct file *
+fdt_get (struct fd_table *fdt, int fd) {
+	if (fd < 0 || fd >= fdt->cap)
+		return NULL;
+	return fdt->files[fd];
+}
+
+/* Releases descriptor FD of FDT and returns the file it referred to,
+ * or a null pointer if FD was not open.  The caller owns the returned
+ * reference. */
+struct file *
+fdt_remove (struct fd_table *fdt, int fd) {
+	struct file *file = fdt_get (fdt, fd);
+	if (file != NULL)
+		slot_clear (fdt, fd);
+	return file;
+}
+
+/* Replaces the contents of DST with a copy of SRC for a forked child.
+ * Every open file gets its own duplicate, so parent and child seek
+ * independently, but descriptors that share one open file in SRC
+ * (after dup2()) also share one in DST.  Work is proportional to the
+ * number of open descriptors.  Returns false if memory allocation
+ * fails; DST must still be passed to fdt_destroy() in that case. */
+bool
+fdt_fork (struct fd_table *dst, struct fd_table *src) {
+	fdt_destroy (dst);
+	dst->cnt = 0;
+	if (!fdt_grow (dst, src->cap))
+		return false;
+
+	for (int fd = fdt_next (src, 0); fd >= 0; fd = fdt_next (src, fd + 1)) {
+		struct file *file = src->files[fd];
+		struct file *nfile = NULL;
+
+		if (fdt_is_console (file)) {
+			slot_set (dst, fd, file);
+			continue;
+		}
+
+		/* Reuse the duplicate made for an earlier alias, if any. */
+		if (file_is_shared (file))
+			for (int prev = fdt_next (src, 0); prev < fd;
+					prev = fdt_next (src, prev + 1))
+				if (src->files[prev] == file) {
+					nfile = file_dup (dst->files[prev]);
+					break;
+				}
+
+		if (nfile == NULL)
+			nfile = file_duplicate (file);
+		if (nfile == NULL)
+			return false;
+		slot_set (dst, fd, nfile);
+	}
+	return true;
+}
+
+/* Closes every descriptor in FDT and frees its storage. */
+void
+fdt_destroy (struct fd_table *fdt) {
+	if (fdt->files == NULL)
+		return;
+
+	for (int fd = fdt_next (fdt, 0); fd >= 0; fd = fdt_next (fdt, fd + 1)) {
+		struct file *file = fdt->files[fd];
+		slot_clear (fdt, fd);
+		if (!fdt_is_console (file))
+			file_close (file);
+	}
+	free (fdt->files);
+	free (fdt->used);
+	fdt->files = NULL;
+	fdt->used = NULL;
+	fdt->cap = 0;
+}
@@ -1,19 +1,30 @@
 #include "userprog/process.h"
 #include <debug.h>
+#include <hash.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/execcache.h"
 #include "userprog/gdt.h"
+#include "userprog/ring.h"
+#include "userprog/shm.h"
+#include "userprog/syscall.h"
+#include "userprog/textcache.h"
+#include "userprog/vdso.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
@@ -26,6 +37,54 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void __do_spawn (void *);
+
+/* What is left of a process once it has exited: its exit status,
+ * held until the parent collects it with wait() or exits itself.
+ * The child releases its address space, files and thread page as
+ * soon as it exits; only this record outlives it.  REF_CNT counts
+ * the parent and the child, and the last one to let go frees it. */
+struct child_record {
+	tid_t tid;
+	struct thread *parent;      /* Null once the parent has let go. */
+	int exit_status;
+	int ref_cnt;
+	struct semaphore exited;    /* Upped when the child exits. */
+	struct hash_elem elem;      /* Element in `records'. */
+	struct list_elem child_elem;/* Element in parent's children_list. */
+};
+
+/* Every live record, keyed by tid, so wait() need not scan the
+ * parent's list.  Records come from their own slab cache. */
+static struct hash records;
+static struct lock records_lock;
+static struct slab_cache record_cache;
+
+static uint64_t record_hash (const struct hash_elem *, void *);
+static bool record_less (const struct hash_elem *, const struct hash_elem *,
+		void *);
+static void record_release (struct child_record *, bool parent);
+
+/* Hand-off between process_spawn() and __do_spawn().  Lives on the
+ * parent's stack, which is safe because the parent sleeps on
+ * sema_fork until the child has finished loading. */
+struct spawn_aux {
+	struct thread *parent;
+	char *cmd_line;             /* Page-sized copy of the command line. */
+	struct spawn_fd *fds;       /* Kernel copy of the remapping list. */
+	size_t fd_cnt;
+	bool success;               /* Set by the child once load() is done. */
+};
+
+/* Initializes the table of child records.  Must run before the
+ * first thread_create(). */
+void
+process_table_init (void) {
+	hash_init (&records, record_hash, record_less, NULL);
+	lock_init (&records_lock);
+	slab_cache_init (&record_cache, "child_record",
+			sizeof (struct child_record));
+}
 
 /* General process initializer for initd and other process. */
 static void
@@ -87,7 +146,6 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	if (ctid == TID_ERROR)
 		return TID_ERROR;
 
-	struct thread *child = get_child_process (ctid);
 	sema_down (&cur->sema_fork);
 
 	return ctid;
@@ -108,6 +166,22 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	if (is_kernel_vaddr (va))
 		return true;
 
+	/* Rings are not inherited. */
+	if (ring_is_page (parent, va))
+		return true;
+
+	/* The kernel data pages are mapped afresh by __do_fork(). */
+	if (vdso_is_page (va))
+		return true;
+
+	/* Shared memory is mapped by shm_fork(). */
+	if (*pte & PTE_SHM)
+		return true;
+
+	/* Shared text pages stay shared. */
+	if (*pte & PTE_TEXT)
+		return textcache_fork (current->pml4, va, pte);
+
 	/* 2. Resolve VA from the parent's page map level 4. */
 	parent_page = pml4_get_page (parent->pml4, va);
 	if (parent_page == NULL)
@@ -167,23 +241,27 @@ __do_fork (void *aux) {
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
 		goto error;
 #endif
+	if (!vdso_map (current))
+		goto error;
+	if (!shm_fork (current, parent))
+		goto error;
+	current->strace = parent->strace;
 
 	/* TODO: Your code goes here.
 	 * TODO: Hint) To duplicate the file object, use `file_duplicate`
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
-	int cnt = 2;
-	struct file **table = parent->fdt;
-	while (cnt < 128) {
-		if (table[cnt]) {
-			current->fdt[cnt] = file_duplicate (table[cnt]);
-		} else {
-			current->fdt[cnt] = NULL;
-		}
-		cnt++;
+	if (!fdt_fork (&current->fdt, &parent->fdt))
+		goto error;
+
+	/* Keep the executable write-protected for as long as we may be
+	 * mapping its text pages. */
+	if (parent->running_file != NULL) {
+		current->running_file = file_duplicate (parent->running_file);
+		if (current->running_file == NULL)
+			goto error;
 	}
-	current->next_fd = parent->next_fd;
 
  	sema_up (&parent->sema_fork);
 
@@ -198,6 +276,128 @@ error:
 	exit (TID_ERROR);
 }
 
+/* Creates a new process running CMD_LINE without cloning the current
+ * one.  Unlike fork() followed by exec(), the caller's address space is
+ * never copied; the child starts with an empty page table and loads the
+ * executable directly.  The child inherits only the console and the
+ * FD_CNT descriptors listed in FDS.  Returns the new process's thread
+ * id, or TID_ERROR if the thread cannot be created or the executable
+ * fails to load. */
+tid_t
+process_spawn (const char *cmd_line, const struct spawn_fd *fds,
+		size_t fd_cnt) {
+	struct thread *cur = thread_current ();
+	struct spawn_aux aux;
+	char name[16], *token, *save_ptr;
+	tid_t ctid;
+
+	aux.parent = cur;
+	aux.fds = NULL;
+	aux.fd_cnt = fd_cnt;
+	aux.success = false;
+
+	/* Copy the command line and the remapping list while the caller's
+	 * address space is still active. */
+	aux.cmd_line = palloc_get_page (0);
+	if (aux.cmd_line == NULL)
+		return TID_ERROR;
+	strlcpy (aux.cmd_line, cmd_line, PGSIZE);
+
+	if (fd_cnt > 0) {
+		aux.fds = malloc (fd_cnt * sizeof *fds);
+		if (aux.fds == NULL) {
+			palloc_free_page (aux.cmd_line);
+			return TID_ERROR;
+		}
+		memcpy (aux.fds, fds, fd_cnt * sizeof *fds);
+	}
+
+	/* Name the thread after the program, as fork()+exec() would. */
+	strlcpy (name, aux.cmd_line, sizeof name);
+	token = strtok_r (name, " ", &save_ptr);
+	if (token == NULL) {
+		palloc_free_page (aux.cmd_line);
+		free (aux.fds);
+		return TID_ERROR;
+	}
+
+	ctid = thread_create (token, PRI_DEFAULT, __do_spawn, &aux);
+	if (ctid == TID_ERROR) {
+		palloc_free_page (aux.cmd_line);
+		free (aux.fds);
+		return TID_ERROR;
+	}
+
+	sema_down (&cur->sema_fork);
+	free (aux.fds);
+
+	/* Reap a child that could not load so it does not linger. */
+	if (!aux.success) {
+		process_wait (ctid);
+		return TID_ERROR;
+	}
+	return ctid;
+}
+
+/* Installs the descriptor remapping requested by spawn() into the
+ * current (child) process.  PARENT is blocked for the duration. */
+static bool
+spawn_fds (struct thread *parent, const struct spawn_fd *fds, size_t fd_cnt) {
+	struct thread *current = thread_current ();
+
+	for (size_t i = 0; i < fd_cnt; i++) {
+		struct file *file = fdt_get (&parent->fdt, fds[i].parent_fd);
+
+		if (file == NULL)
+			return false;
+		if (!fdt_is_console (file)) {
+			file = file_duplicate (file);
+			if (file == NULL)
+				return false;
+		}
+		if (!fdt_install (&current->fdt, fds[i].child_fd, file)) {
+			if (!fdt_is_console (file))
+				file_close (file);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* A thread function that builds a spawned process from scratch. */
+static void
+__do_spawn (void *aux_) {
+	struct spawn_aux *aux = aux_;
+	struct thread *parent = aux->parent;
+	char *cmd_line = aux->cmd_line;
+	struct intr_frame _if;
+	bool success = false;
+
+#ifdef VM
+	supplemental_page_table_init (&thread_current ()->spt);
+#endif
+
+	process_init ();
+
+	_if.ds = _if.es = _if.ss = SEL_UDSEG;
+	_if.cs = SEL_UCSEG;
+	_if.eflags = FLAG_IF | FLAG_MBS;
+
+	if (spawn_fds (parent, aux->fds, aux->fd_cnt))
+		success = load (cmd_line, &_if);
+	palloc_free_page (cmd_line);
+
+	/* AUX belongs to the parent's stack; do not touch it after this. */
+	aux->success = success;
+	sema_up (&parent->sema_fork);
+
+	if (!success)
+		exit (-1);
+
+	do_iret (&_if);
+	NOT_REACHED ();
+}
+
 /* Switch the current execution context to the f_name.
  * Returns -1 on fail. */
 int
@@ -244,15 +444,15 @@ process_wait (tid_t child_tid UNUSED) {
 	/* XXX: Hint) The pintos exit if process_wait (initd), we recommend you
 	 * XXX:       to add infinite loop here before
 	 * XXX:       implementing the process_wait. */
-	struct thread *child = get_child_process(child_tid);
+	struct child_record *child = get_child_process (child_tid);
 
 	if (child == NULL)
 		return -1;
 
-	sema_down (&child->sema_wait);
+	sema_down (&child->exited);
 	int exit_status = child->exit_status;
 	list_remove (&child->child_elem);
-	sema_up (&child->sema_exit);
+	record_release (child, true);
 	return exit_status;
 }
 
@@ -260,28 +460,26 @@ process_wait (tid_t child_tid UNUSED) {
 void
 process_exit (void) {
 	struct thread *curr = thread_current ();
-	struct file **table = curr->fdt;
 	/* TODO: Your code goes here.
 	 * TODO: Implement process termination message (see
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
-	if (curr->running_file)
-		file_close (curr->running_file);
+	fdt_destroy (&curr->fdt);
+	process_cleanup ();
 
-	int cnt = 2;
-	while (cnt < 128) {
-		if (table[cnt]) {
-			file_close (table[cnt]);
-			table[cnt] = NULL;
-		}
-		cnt++;
+	/* Nobody can wait for our children any more. */
+	while (!list_empty (&curr->children_list)) {
+		struct list_elem *e = list_pop_front (&curr->children_list);
+		record_release (list_entry (e, struct child_record, child_elem), true);
 	}
 
-	sema_up(&curr->sema_wait);
-	sema_down(&curr->sema_exit);
-
-	palloc_free_page(table);
-	process_cleanup ();
+	/* Leave only the exit status behind for the parent. */
+	if (curr->record != NULL) {
+		curr->record->exit_status = curr->exit_status;
+		sema_up (&curr->record->exited);
+		record_release (curr->record, false);
+		curr->record = NULL;
+	}
 }
 
 /* Free the current process's resources. */
@@ -293,6 +491,11 @@ process_cleanup (void) {
 	supplemental_page_table_kill (&curr->spt);
 #endif
 
+	/* The ring's page goes away with the page table.  Shared memory
+	 * frames must be unmapped first, or pml4_destroy() frees them. */
+	ring_destroy (curr);
+	shm_destroy (curr);
+
 	uint64_t *pml4;
 	/* Destroy the current process's page directory and switch back
 	 * to the kernel-only page directory. */
@@ -307,8 +510,19 @@ process_cleanup (void) {
 		 * that's been freed (and cleared). */
 		curr->pml4 = NULL;
 		pml4_activate (NULL);
+#ifndef VM
+		textcache_unmap_all (pml4);
+#endif
+		vdso_unmap (pml4);
 		pml4_destroy (pml4);
 	}
+
+	/* Only now that no text page of the executable is mapped may it
+	 * be written again. */
+	if (curr->running_file != NULL) {
+		file_close (curr->running_file);
+		curr->running_file = NULL;
+	}
 }
 
 /* Sets up the CPU for running user code in the nest thread.
@@ -377,6 +591,7 @@ struct ELF64_PHDR {
 
 static bool setup_stack (struct intr_frame *if_);
 static bool validate_segment (const struct Phdr *, struct file *);
+static struct exec_image *parse_image (struct file *, const char *file_name);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		uint32_t read_bytes, uint32_t zero_bytes,
 		bool writable);
@@ -388,9 +603,9 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 load (const char *file_name, struct intr_frame *if_) {
 	struct thread *t = thread_current ();
-	struct ELF ehdr;
+	struct exec_image *image = NULL;
+	struct inode *inode;
 	struct file *file = NULL;
-	off_t file_ofs;
 	bool success = false;
 	int i;
 
@@ -416,7 +631,69 @@ load (const char *file_name, struct intr_frame *if_) {
 		goto done;
 	}
 
+	/* Use the cached headers if this executable has not changed since
+	 * it was last loaded; otherwise parse them and cache the result. */
+	inode = file_get_inode (file);
+	image = execcache_lookup (inode);
+	if (image == NULL) {
+		uint64_t generation = inode_get_generation (inode);
+
+		image = parse_image (file, file_name);
+		if (image == NULL)
+			goto done;
+		execcache_insert (inode, generation, image);
+	}
+
+	/* Map the loadable segments. */
+	for (i = 0; i < image->seg_cnt; i++) {
+		struct exec_segment *seg = &image->segs[i];
+		if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+					seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
+	}
+
+	/* Set up stack. */
+	if (!setup_stack (if_))
+		goto done;
+
+	/* Map the kernel data pages. */
+	if (!vdso_map (t))
+		goto done;
+
+	/* Start address. */
+	if_->rip = image->entry;
+
+	/* TODO: Your code goes here.
+	 * TODO: Implement argument passing (see project2/argument_passing.html). */
+	argument_stack (argv, cnt, &if_->rsp);
+	if_->R.rdi = cnt;
+	if_->R.rsi = if_->rsp + 8;
+
+	success = true;
+
+	t->running_file = file;
+	file_deny_write (file);
+
+done:
+	/* We arrive here whether the load is successful or not. */
+	// file_close (file);
+	free (image);
+	return success;
+}
+
+/* Reads and verifies the ELF header and program headers of FILE, an
+ * executable named FILE_NAME.  Returns its loadable segments and entry
+ * point in a new exec_image, which the caller must free(), or a null
+ * pointer if FILE is not a loadable executable. */
+static struct exec_image *
+parse_image (struct file *file, const char *file_name) {
+	struct ELF ehdr;
+	struct exec_image *image;
+	off_t file_ofs;
+	int i;
+
 	/* Read and verify executable header. */
+	file_seek (file, 0);
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
 			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
 			|| ehdr.e_type != 2
@@ -425,20 +702,26 @@ load (const char *file_name, struct intr_frame *if_) {
 			|| ehdr.e_phentsize != sizeof (struct Phdr)
 			|| ehdr.e_phnum > 1024) {
 		printf ("load: %s: error loading executable\n", file_name);
-		goto done;
+		return NULL;
 	}
 
+	image = malloc (exec_image_size (ehdr.e_phnum));
+	if (image == NULL)
+		return NULL;
+	image->entry = ehdr.e_entry;
+	image->seg_cnt = 0;
+
 	/* Read program headers. */
 	file_ofs = ehdr.e_phoff;
 	for (i = 0; i < ehdr.e_phnum; i++) {
 		struct Phdr phdr;
 
 		if (file_ofs < 0 || file_ofs > file_length (file))
-			goto done;
+			goto fail;
 		file_seek (file, file_ofs);
 
 		if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
+			goto fail;
 		file_ofs += sizeof phdr;
 		switch (phdr.p_type) {
 			case PT_NULL:
@@ -451,73 +734,112 @@ load (const char *file_name, struct intr_frame *if_) {
 			case PT_DYNAMIC:
 			case PT_INTERP:
 			case PT_SHLIB:
-				goto done;
+				goto fail;
 			case PT_LOAD:
 				if (validate_segment (&phdr, file)) {
-					bool writable = (phdr.p_flags & PF_W) != 0;
-					uint64_t file_page = phdr.p_offset & ~PGMASK;
-					uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
+					struct exec_segment *seg = &image->segs[image->seg_cnt++];
 					uint64_t page_offset = phdr.p_vaddr & PGMASK;
-					uint32_t read_bytes, zero_bytes;
+
+					seg->writable = (phdr.p_flags & PF_W) != 0;
+					seg->file_page = phdr.p_offset & ~PGMASK;
+					seg->mem_page = phdr.p_vaddr & ~PGMASK;
 					if (phdr.p_filesz > 0) {
 						/* Normal segment.
 						 * Read initial part from disk and zero the rest. */
-						read_bytes = page_offset + phdr.p_filesz;
-						zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-								- read_bytes);
+						seg->read_bytes = page_offset + phdr.p_filesz;
+						seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
+								- seg->read_bytes);
 					} else {
 						/* Entirely zero.
 						 * Don't read anything from disk. */
-						read_bytes = 0;
-						zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+						seg->read_bytes = 0;
+						seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
 					}
-					if (!load_segment (file, file_page, (void *) mem_page,
-								read_bytes, zero_bytes, writable))
-						goto done;
 				}
 				else
-					goto done;
+					goto fail;
 				break;
 		}
 	}
+	return image;
 
-	/* Set up stack. */
-	if (!setup_stack (if_))
-		goto done;
+fail:
+	free (image);
+	return NULL;
+}
 
-	/* Start address. */
-	if_->rip = ehdr.e_entry;
+/* Creates the exit record of CHILD, which the current thread is
+ * creating, and links it into our children_list.  Returns false if
+ * memory allocation fails. */
+bool
+process_add_child (struct thread *child) {
+	struct child_record *rec = slab_alloc (&record_cache);
+	if (rec == NULL)
+		return false;
 
-	/* TODO: Your code goes here.
-	 * TODO: Implement argument passing (see project2/argument_passing.html). */
-	argument_stack (argv, cnt, &if_->rsp);
-	if_->R.rdi = cnt;
-	if_->R.rsi = if_->rsp + 8;
+	rec->tid = child->tid;
+	rec->parent = thread_current ();
+	rec->exit_status = -1;
+	rec->ref_cnt = 2;
+	sema_init (&rec->exited, 0);
 
-	success = true;
+	lock_acquire (&records_lock);
+	hash_insert (&records, &rec->elem);
+	lock_release (&records_lock);
 
-	t->running_file = file;
-	file_deny_write (file);
+	list_push_back (&rec->parent->children_list, &rec->child_elem);
+	child->record = rec;
+	return true;
+}
 
-done:
-	/* We arrive here whether the load is successful or not. */
-	// file_close (file);
-	return success;
+/* Returns the record of the current thread's child PID, or a null
+ * pointer if PID is not a child we can still wait for. */
+struct child_record *get_child_process (int pid) {
+	struct child_record key, *rec = NULL;
+	struct hash_elem *e;
+
+	key.tid = pid;
+	lock_acquire (&records_lock);
+	e = hash_find (&records, &key.elem);
+	if (e != NULL) {
+		rec = hash_entry (e, struct child_record, elem);
+		if (rec->parent != thread_current ())
+			rec = NULL;
+	}
+	lock_release (&records_lock);
+	return rec;
 }
 
-struct thread *get_child_process (int pid) {
-	struct thread *cur = thread_current();
-	struct list *child_list = &cur->children_list;
-	struct list_elem *cur_child = list_begin (child_list);
+/* Drops one reference to REC, by its parent if PARENT is true or
+ * otherwise by the child itself, and frees REC with the last one.
+ * Once the parent lets go, REC can no longer be found. */
+static void
+record_release (struct child_record *rec, bool parent) {
+	bool last;
 
-	while (cur_child != list_end (child_list)) {
-	struct thread *cur_t = list_entry (cur_child, struct thread, child_elem);
-	if (cur_t->tid == pid) {
-		return cur_t;
-	}
-	cur_child = list_next (cur_child);
+	lock_acquire (&records_lock);
+	if (parent) {
+		rec->parent = NULL;
+		hash_delete (&records, &rec->elem);
 	}
-	return NULL;
+	last = --rec->ref_cnt == 0;
+	lock_release (&records_lock);
+
+	if (last)
+		slab_free (&record_cache, rec);
+}
+
+static uint64_t
+record_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct child_record *rec = hash_entry (e, struct child_record, elem);
+	return hash_int (rec->tid);
+}
+
+static bool
+record_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct child_record, elem)->tid
+		< hash_entry (b, struct child_record, elem)->tid;
 }
 
 void argument_stack (char **parse, int count, void **esp) {
@@ -624,7 +946,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
-	file_seek (file, ofs);
 	while (read_bytes > 0 || zero_bytes > 0) {
 		/* Do calculate how to fill this page.
 		 * We will read PAGE_READ_BYTES bytes from FILE
@@ -632,29 +953,39 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-		/* Get a page of memory. */
-		uint8_t *kpage = palloc_get_page (PAL_USER);
-		if (kpage == NULL)
-			return false;
-
-		/* Load this page. */
-		if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes) {
-			palloc_free_page (kpage);
-			return false;
-		}
-		memset (kpage + page_read_bytes, 0, page_zero_bytes);
-
-		/* Add the page to the process's address space. */
-		if (!install_page (upage, kpage, writable)) {
-			printf("fail\n");
-			palloc_free_page (kpage);
-			return false;
+		if (!writable) {
+			/* Read-only pages are shared with every other process
+			 * running this executable. */
+			if (!textcache_map (thread_current ()->pml4, upage, file, ofs,
+						page_read_bytes))
+				return false;
+		} else {
+			/* Get a page of memory. */
+			uint8_t *kpage = palloc_get_page (PAL_USER);
+			if (kpage == NULL)
+				return false;
+
+			/* Load this page. */
+			if (file_read_at (file, kpage, page_read_bytes, ofs)
+					!= (int) page_read_bytes) {
+				palloc_free_page (kpage);
+				return false;
+			}
+			memset (kpage + page_read_bytes, 0, page_zero_bytes);
+
+			/* Add the page to the process's address space. */
+			if (!install_page (upage, kpage, writable)) {
+				printf("fail\n");
+				palloc_free_page (kpage);
+				return false;
+			}
 		}
 
 		/* Advance. */
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
 		upage += PGSIZE;
+		ofs += PGSIZE;
 	}
 	return true;
 }
@@ -0,0 +1,153 @@
+#include "userprog/ring.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+
+/* User address at which the ring page is mapped. */
+#define RING_UADDR ((void *) 0x10000000)
+
+/* A process's ring.  The shared page can be scribbled on by the
+ * process at any time, so the kernel keeps its own copies of the
+ * queue sizes and of the counters that it owns, and copies each
+ * submission out of the page before looking at it. */
+struct io_ring {
+	struct ring *ring;          /* Kernel address of the shared page. */
+	uint32_t sq_entries;        /* Submission queue size. */
+	uint32_t cq_entries;        /* Completion queue size. */
+	uint32_t sq_head;           /* Next submission to execute. */
+	uint32_t cq_tail;           /* Next completion slot. */
+};
+
+static int32_t ring_execute (const struct ring_sqe *);
+
+/* Creates a ring with ENTRIES submission slots for the current
+ * process and maps it into its address space.  Returns the user
+ * address of the struct ring, or a null pointer if ENTRIES is out of
+ * range, the process already has a ring, or memory is exhausted. */
+void *
+ring_setup (unsigned entries) {
+	struct thread *cur = thread_current ();
+	struct io_ring *r;
+
+	ASSERT (sizeof (struct ring) <= PGSIZE);
+
+	if (entries == 0 || entries > RING_MAX_ENTRIES || cur->ring != NULL
+			|| pml4_get_page (cur->pml4, RING_UADDR) != NULL)
+		return NULL;
+
+	r = malloc (sizeof *r);
+	if (r == NULL)
+		return NULL;
+	r->ring = palloc_get_page (PAL_USER | PAL_ZERO);
+	if (r->ring == NULL) {
+		free (r);
+		return NULL;
+	}
+	if (!pml4_set_page (cur->pml4, RING_UADDR, r->ring, true)) {
+		palloc_free_page (r->ring);
+		free (r);
+		return NULL;
+	}
+
+	r->sq_entries = entries;
+	r->cq_entries = 2 * entries;
+	r->sq_head = 0;
+	r->cq_tail = 0;
+	r->ring->sq_entries = r->sq_entries;
+	r->ring->cq_entries = r->cq_entries;
+	cur->ring = r;
+	return RING_UADDR;
+}
+
+/* Executes up to TO_SUBMIT queued submissions of the current
+ * process's ring, in order, posting a completion for each.  Stops
+ * early when the submission queue is empty or the completion queue
+ * is full.  Every submission has completed when this returns.
+ * Returns the number of submissions consumed, or -1 if the process
+ * has no ring or its counters are corrupt. */
+int
+ring_enter (unsigned to_submit) {
+	struct io_ring *r = thread_current ()->ring;
+	int done = 0;
+
+	if (r == NULL)
+		return -1;
+
+	while ((unsigned) done < to_submit) {
+		volatile struct ring *ring = r->ring;
+		uint32_t sq_tail = ring->sq_tail;
+		uint32_t cq_head = ring->cq_head;
+		struct ring_sqe sqe;
+		struct ring_cqe *cqe;
+
+		if (sq_tail - r->sq_head > r->sq_entries
+				|| r->cq_tail - cq_head > r->cq_entries)
+			return -1;
+		if (sq_tail == r->sq_head || r->cq_tail - cq_head == r->cq_entries)
+			break;
+
+		memcpy (&sqe, &r->ring->sqes[r->sq_head % r->sq_entries], sizeof sqe);
+		r->sq_head++;
+		ring->sq_head = r->sq_head;
+
+		cqe = &r->ring->cqes[r->cq_tail % r->cq_entries];
+		cqe->user_data = sqe.user_data;
+		cqe->res = ring_execute (&sqe);
+		r->cq_tail++;
+		ring->cq_tail = r->cq_tail;
+		done++;
+	}
+	return done;
+}
+
+/* Returns true if VA is the page of T's ring. */
+bool
+ring_is_page (struct thread *t, void *va) {
+	return t->ring != NULL && va == RING_UADDR;
+}
+
+/* Releases T's ring.  The shared page itself belongs to T's page
+ * table and is freed along with it. */
+void
+ring_destroy (struct thread *t) {
+	free (t->ring);
+	t->ring = NULL;
+}
+
+/* Carries out SQE and returns what the equivalent system call would.
+ * Bad user pointers kill the process, as they do in system calls. */
+static int32_t
+ring_execute (const struct ring_sqe *sqe) {
+	void *addr = (void *) sqe->addr;
+
+	switch (sqe->opcode) {
+		case RING_OP_NOP:
+			return 0;
+		case RING_OP_READ:
+			return read (sqe->fd, addr, sqe->len);
+		case RING_OP_WRITE:
+			return write (sqe->fd, addr, sqe->len);
+		case RING_OP_OPEN:
+			return open (addr);
+		case RING_OP_CLOSE:
+			if (fdt_get (&thread_current ()->fdt, sqe->fd) == NULL)
+				return -1;
+			close (sqe->fd);
+			return 0;
+		case RING_OP_PREAD:
+			if (sqe->off > INT32_MAX)
+				return -1;
+			return pread (sqe->fd, addr, sqe->len, sqe->off);
+		case RING_OP_FSYNC:
+			return fsync (sqe->fd);
+		default:
+			return -1;
+	}
+}
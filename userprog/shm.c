@@ -0,0 +1,305 @@
+#include "userprog/shm.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+
+/* Named shared memory segments.
+
+   A segment is a set of frames that any number of processes can map,
+   each at an address of its choosing.  A process first opens the
+   segment by name, which creates it if needed, and may then map it.
+   Every open and every mapping holds a reference to the segment,
+   recorded in the process's SHM_REFS list; the frames are freed when
+   the last reference goes away.  Mappings carry PTE_SHM in the page
+   table, so that fork() leaves them to shm_fork() and pml4_destroy()
+   never sees a frame it does not own. */
+
+struct shm_segment {
+	char name[SHM_NAME_MAX + 1];    /* Name. */
+	int id;                     /* Identifier returned by shm_open(). */
+	size_t page_cnt;            /* Number of pages. */
+	void **kpages;              /* PAGE_CNT frames. */
+	int ref_cnt;                /* Opens plus mappings. */
+	struct list_elem elem;      /* Element in segments. */
+};
+
+/* A process's reference to a segment. */
+struct shm_ref {
+	struct shm_segment *seg;    /* Segment. */
+	void *uaddr;                /* Where mapped, or null for an open. */
+	struct list_elem elem;      /* Element in thread's shm_refs. */
+};
+
+static struct list segments;    /* All segments. */
+static struct lock shm_lock;    /* Protects SEGMENTS and ref counts. */
+static int next_id;             /* Next segment identifier. */
+
+static struct shm_ref *find_ref (struct thread *, int id, void *uaddr);
+static bool add_ref (struct thread *, struct shm_segment *, void *uaddr);
+static void drop_ref (struct thread *, struct shm_ref *);
+static void remove_ref (struct shm_ref *);
+static void free_segment (struct shm_segment *);
+static bool map_pages (uint64_t *pml4, struct shm_segment *, void *uaddr);
+static void unmap_pages (uint64_t *pml4, struct shm_segment *, void *uaddr);
+
+/* Initializes the segment table. */
+void
+shm_init (void) {
+	list_init (&segments);
+	lock_init (&shm_lock);
+}
+
+/* Creates a segment of SIZE bytes, rounded up to whole pages, named
+ * NAME, unless one with that name already exists.  Opens the segment
+ * for the current process and returns its identifier, or -1 if NAME
+ * is too long, the segment would be empty or too large, an existing
+ * segment is smaller than SIZE, or memory is exhausted. */
+int
+shm_open (const char *name, size_t size) {
+	struct thread *cur = thread_current ();
+	struct shm_segment *seg = NULL;
+	struct list_elem *e;
+	int id = -1;
+
+	check_address (name);
+	if (strlen (name) > SHM_NAME_MAX)
+		return -1;
+
+	lock_acquire (&shm_lock);
+	for (e = list_begin (&segments); e != list_end (&segments);
+			e = list_next (e)) {
+		struct shm_segment *s = list_entry (e, struct shm_segment, elem);
+		if (!strcmp (s->name, name)) {
+			seg = s;
+			break;
+		}
+	}
+
+	if (seg == NULL) {
+		size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+		if (page_cnt == 0 || page_cnt > SHM_MAX_PAGES)
+			goto done;
+		seg = calloc (1, sizeof *seg);
+		if (seg == NULL)
+			goto done;
+		seg->kpages = calloc (page_cnt, sizeof *seg->kpages);
+		if (seg->kpages == NULL) {
+			free (seg);
+			goto done;
+		}
+		strlcpy (seg->name, name, sizeof seg->name);
+		seg->id = next_id++;
+		seg->page_cnt = page_cnt;
+		list_push_back (&segments, &seg->elem);
+		for (size_t i = 0; i < page_cnt; i++)
+			if ((seg->kpages[i] = palloc_get_page (PAL_USER | PAL_ZERO)) == NULL) {
+				free_segment (seg);
+				goto done;
+			}
+	} else if (size > seg->page_cnt * PGSIZE)
+		goto done;
+
+	if (find_ref (cur, seg->id, NULL) != NULL || add_ref (cur, seg, NULL))
+		id = seg->id;
+	else if (seg->ref_cnt == 0)
+		free_segment (seg);
+
+done:
+	lock_release (&shm_lock);
+	return id;
+}
+
+/* Maps segment ID, which the current process must have opened, at
+ * user address ADDR.  ADDR must be page-aligned and the pages there
+ * unmapped.  Returns ADDR, or a null pointer on failure. */
+void *
+shm_map (int id, void *addr) {
+	struct thread *cur = thread_current ();
+	struct shm_ref *open_ref;
+	struct shm_segment *seg;
+	void *result = NULL;
+
+	if (addr == NULL || pg_ofs (addr) != 0 || !is_user_vaddr (addr))
+		return NULL;
+
+	lock_acquire (&shm_lock);
+	open_ref = find_ref (cur, id, NULL);
+	if (open_ref == NULL)
+		goto done;
+	seg = open_ref->seg;
+	if (!is_user_vaddr ((uint8_t *) addr + seg->page_cnt * PGSIZE - 1))
+		goto done;
+	for (size_t i = 0; i < seg->page_cnt; i++)
+		if (pml4_get_page (cur->pml4, (uint8_t *) addr + i * PGSIZE) != NULL)
+			goto done;
+
+	if (!add_ref (cur, seg, addr))
+		goto done;
+	if (!map_pages (cur->pml4, seg, addr)) {
+		remove_ref (find_ref (cur, id, addr));
+		goto done;
+	}
+	result = addr;
+
+done:
+	lock_release (&shm_lock);
+	return result;
+}
+
+/* Removes the segment mapping at ADDR from the current process.
+ * Returns 0 if successful, -1 if no segment is mapped there. */
+int
+shm_unmap (void *addr) {
+	struct thread *cur = thread_current ();
+	struct shm_ref *ref;
+
+	if (addr == NULL)
+		return -1;
+	lock_acquire (&shm_lock);
+	ref = find_ref (cur, -1, addr);
+	lock_release (&shm_lock);
+	if (ref == NULL)
+		return -1;
+	drop_ref (cur, ref);
+	return 0;
+}
+
+/* Gives CHILD, which is being forked from PARENT, the same opens and
+ * mappings of segments as PARENT.  CHILD's page table must be set
+ * up.  Returns false if memory is exhausted; CHILD must still be
+ * passed to shm_destroy() then. */
+bool
+shm_fork (struct thread *child, struct thread *parent) {
+	bool success = true;
+	struct list_elem *e;
+
+	lock_acquire (&shm_lock);
+	for (e = list_begin (&parent->shm_refs); e != list_end (&parent->shm_refs);
+			e = list_next (e)) {
+		struct shm_ref *ref = list_entry (e, struct shm_ref, elem);
+		if (!add_ref (child, ref->seg, ref->uaddr)
+				|| (ref->uaddr != NULL
+					&& !map_pages (child->pml4, ref->seg, ref->uaddr))) {
+			success = false;
+			break;
+		}
+	}
+	lock_release (&shm_lock);
+	return success;
+}
+
+/* Drops all of T's opens and mappings of segments.  Must be called
+ * before T's page table is destroyed. */
+void
+shm_destroy (struct thread *t) {
+	while (!list_empty (&t->shm_refs))
+		drop_ref (t, list_entry (list_front (&t->shm_refs),
+					struct shm_ref, elem));
+}
+
+/* Returns T's reference with segment identifier ID, or any
+ * identifier if ID is -1, and mapping address UADDR. */
+static struct shm_ref *
+find_ref (struct thread *t, int id, void *uaddr) {
+	struct list_elem *e;
+
+	ASSERT (lock_held_by_current_thread (&shm_lock));
+	for (e = list_begin (&t->shm_refs); e != list_end (&t->shm_refs);
+			e = list_next (e)) {
+		struct shm_ref *ref = list_entry (e, struct shm_ref, elem);
+		if ((id == -1 || ref->seg->id == id) && ref->uaddr == uaddr)
+			return ref;
+	}
+	return NULL;
+}
+
+/* Records a reference by T to SEG, mapped at UADDR or an open if
+ * UADDR is null.  Returns false if memory is exhausted. */
+static bool
+add_ref (struct thread *t, struct shm_segment *seg, void *uaddr) {
+	struct shm_ref *ref;
+
+	ASSERT (lock_held_by_current_thread (&shm_lock));
+	ref = malloc (sizeof *ref);
+	if (ref == NULL)
+		return false;
+	ref->seg = seg;
+	ref->uaddr = uaddr;
+	list_push_back (&t->shm_refs, &ref->elem);
+	seg->ref_cnt++;
+	return true;
+}
+
+/* Drops REF, a reference by T, unmapping the segment if REF is a
+ * mapping. */
+static void
+drop_ref (struct thread *t, struct shm_ref *ref) {
+	lock_acquire (&shm_lock);
+	if (ref->uaddr != NULL && t->pml4 != NULL)
+		unmap_pages (t->pml4, ref->seg, ref->uaddr);
+	remove_ref (ref);
+	lock_release (&shm_lock);
+}
+
+/* Removes REF from its process's list and frees its segment if this
+ * was the segment's last reference. */
+static void
+remove_ref (struct shm_ref *ref) {
+	struct shm_segment *seg = ref->seg;
+
+	ASSERT (lock_held_by_current_thread (&shm_lock));
+	list_remove (&ref->elem);
+	free (ref);
+	if (--seg->ref_cnt == 0)
+		free_segment (seg);
+}
+
+/* Frees SEG and whatever frames it has. */
+static void
+free_segment (struct shm_segment *seg) {
+	ASSERT (lock_held_by_current_thread (&shm_lock));
+	list_remove (&seg->elem);
+	for (size_t i = 0; i < seg->page_cnt; i++)
+		if (seg->kpages[i] != NULL)
+			palloc_free_page (seg->kpages[i]);
+	free (seg->kpages);
+	free (seg);
+}
+
+/* Maps SEG's frames at UADDR in PML4, writable and marked PTE_SHM.
+ * Undoes any partial mapping and returns false on failure. */
+static bool
+map_pages (uint64_t *pml4, struct shm_segment *seg, void *uaddr) {
+	for (size_t i = 0; i < seg->page_cnt; i++) {
+		void *upage = (uint8_t *) uaddr + i * PGSIZE;
+		uint64_t *pte;
+
+		if (!pml4_set_page (pml4, upage, seg->kpages[i], true)) {
+			for (size_t j = 0; j < i; j++)
+				pml4_clear_page (pml4, (uint8_t *) uaddr + j * PGSIZE);
+			return false;
+		}
+		pte = pml4e_walk (pml4, (uint64_t) upage, 0);
+		*pte |= PTE_SHM;
+	}
+	return true;
+}
+
+/* Removes SEG's mapping at UADDR from PML4. */
+static void
+unmap_pages (uint64_t *pml4, struct shm_segment *seg, void *uaddr) {
+	for (size_t i = 0; i < seg->page_cnt; i++) {
+		void *upage = (uint8_t *) uaddr + i * PGSIZE;
+		if (pml4_get_page (pml4, upage) == seg->kpages[i])
+			pml4_clear_page (pml4, upage);
+	}
+}
@@ -0,0 +1,108 @@
+#include "userprog/strace.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+
+/* System call tracing.
+
+   Traced calls are appended as fixed-size binary records to one
+   kernel-wide ring that overwrites its oldest records when full.
+   Nothing is formatted while tracing; strace_dump() prints the
+   surviving records when the kernel powers off. */
+
+/* Size of the trace ring. */
+#define STRACE_PAGES 16
+#define STRACE_CNT (STRACE_PAGES * PGSIZE / sizeof (struct strace_rec))
+
+bool strace_all;
+
+static struct strace_rec *trace;    /* The ring, or null. */
+static uint64_t trace_cnt;          /* Records ever appended. */
+static struct lock trace_lock;      /* Serializes allocating TRACE. */
+
+/* Sets up tracing, and allocates the ring now if -strace was given. */
+void
+strace_init (void) {
+	lock_init (&trace_lock);
+	if (strace_all)
+		trace = palloc_get_multiple (PAL_ASSERT, STRACE_PAGES);
+}
+
+/* Turns tracing of the current process on or off according to
+ * ENABLE.  The setting is inherited by forked children.  Returns
+ * the previous setting, or false if the ring cannot be allocated. */
+bool
+strace_enable (bool enable) {
+	struct thread *cur = thread_current ();
+	bool old = cur->strace;
+
+	if (enable && trace == NULL) {
+		lock_acquire (&trace_lock);
+		if (trace == NULL)
+			trace = palloc_get_multiple (0, STRACE_PAGES);
+		lock_release (&trace_lock);
+		if (trace == NULL)
+			return false;
+	}
+	cur->strace = enable;
+	return old;
+}
+
+/* Returns true if the current process's system calls are traced. */
+bool
+strace_active (void) {
+	return trace != NULL && (strace_all || thread_current ()->strace);
+}
+
+/* Appends a record of system call NR, with the ARGC arguments in
+ * ARGS, that began at TSC, took CYCLES and returned RET. */
+void
+strace_record (int nr, const uint64_t *args, int argc, uint64_t ret,
+		uint64_t tsc, uint64_t cycles) {
+	struct strace_rec *r;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	r = &trace[trace_cnt++ % STRACE_CNT];
+	intr_set_level (old_level);
+
+	/* A writer that wraps all the way around the ring before we are
+	 * done here can garble this record, which is fine for a trace. */
+	r->tsc = tsc;
+	r->ret = ret;
+	memset (r->args, 0, sizeof r->args);
+	memcpy (r->args, args, (argc < STRACE_ARGS ? argc : STRACE_ARGS)
+			* sizeof *args);
+	r->cycles = cycles > UINT32_MAX ? UINT32_MAX : cycles;
+	r->tid = thread_tid ();
+	r->nr = nr;
+	r->argc = argc;
+}
+
+/* Prints the records in the ring, oldest first. */
+void
+strace_dump (void) {
+	uint64_t first;
+
+	if (trace == NULL || trace_cnt == 0)
+		return;
+
+	first = trace_cnt > STRACE_CNT ? trace_cnt - STRACE_CNT : 0;
+	if (first > 0)
+		printf ("strace: %llu earlier records overwritten\n", first);
+	for (uint64_t i = first; i < trace_cnt; i++) {
+		struct strace_rec *r = &trace[i % STRACE_CNT];
+
+		printf ("strace: %llu %d %s(", r->tsc, r->tid, syscall_name (r->nr));
+		for (int j = 0; j < r->argc && j < STRACE_ARGS; j++)
+			printf ("%s%#llx", j > 0 ? ", " : "", r->args[j]);
+		printf ("%s) = %lld <%u cycles>\n", r->argc > STRACE_ARGS ? ", ..." : "",
+				r->ret, r->cycles);
+	}
+}
@@ -1,13 +1,23 @@
 #include "userprog/syscall.h"
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <vdso.h>
+#include "devices/input.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
+#include "userprog/execcache.h"
 #include "userprog/gdt.h"
+#include "userprog/ring.h"
+#include "userprog/shm.h"
+#include "userprog/strace.h"
 #include "threads/flags.h"
 #include "intrinsic.h"
 
@@ -29,8 +39,6 @@ void syscall_handler (struct intr_frame *);
 
 void
 syscall_init (void) {
-	lock_init (&filesys_lock);
-
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
 			((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
@@ -42,59 +50,181 @@ syscall_init (void) {
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 }
 
-/* The main system call interface */
+/* Wrappers that unpack a system call's arguments, in the order of the
+ * user's %rdi, %rsi, %rdx, %r10, %r8 and %r9, and call its
+ * implementation.  F is the caller's interrupt frame. */
+#define SYSCALL(NAME) static uint64_t \
+		sys_##NAME (const uint64_t *a UNUSED, struct intr_frame *f UNUSED)
+
+SYSCALL (halt) { halt (); return 0; }
+SYSCALL (exit) { exit (a[0]); return 0; }
+SYSCALL (fork) {
+	memcpy (&thread_current ()->ptf, f, sizeof (struct intr_frame));
+	return fork ((const char *) a[0]);
+}
+SYSCALL (exec) { return exec ((const char *) a[0]); }
+SYSCALL (wait) { return wait (a[0]); }
+SYSCALL (create) { return create ((const char *) a[0], a[1]); }
+SYSCALL (remove) { return remove ((const char *) a[0]); }
+SYSCALL (open) { return open ((const char *) a[0]); }
+SYSCALL (filesize) { return filesize (a[0]); }
+SYSCALL (read) { return read (a[0], (void *) a[1], a[2]); }
+SYSCALL (write) { return write (a[0], (const void *) a[1], a[2]); }
+SYSCALL (seek) { seek (a[0], a[1]); return 0; }
+SYSCALL (tell) { return tell (a[0]); }
+SYSCALL (close) { close (a[0]); return 0; }
+SYSCALL (dup2) { return dup2 (a[0], a[1]); }
+SYSCALL (spawn) {
+	return spawn ((const char *) a[0], (const struct spawn_fd *) a[1], a[2]);
+}
+SYSCALL (pread) { return pread (a[0], (void *) a[1], a[2], a[3]); }
+SYSCALL (pwrite) { return pwrite (a[0], (const void *) a[1], a[2], a[3]); }
+SYSCALL (readv) { return readv (a[0], (const struct iovec *) a[1], a[2]); }
+SYSCALL (writev) { return writev (a[0], (const struct iovec *) a[1], a[2]); }
+SYSCALL (copy_file_range) {
+	return copy_file_range (a[0], (off_t *) a[1], a[2], (off_t *) a[3], a[4]);
+}
+SYSCALL (ring_setup) { return (uint64_t) ring_setup (a[0]); }
+SYSCALL (ring_enter) { return ring_enter (a[0]); }
+SYSCALL (strace) { return strace_enable (a[0]); }
+SYSCALL (ttymode) { return ttymode (a[0]); }
+SYSCALL (pipe) { return pipe ((int *) a[0]); }
+SYSCALL (shm_open) { return shm_open ((const char *) a[0], a[1]); }
+SYSCALL (shm_map) { return (uint64_t) shm_map (a[0], (void *) a[1]); }
+SYSCALL (shm_unmap) { return shm_unmap ((void *) a[0]); }
+
+/* Describes one system call. */
+struct syscall_desc {
+	const char *name;           /* Name, for statistics and traces. */
+	int argc;                   /* Number of arguments. */
+	uint64_t (*func) (const uint64_t *, struct intr_frame *);
+};
+
+#define ENTRY(NR, NAME, ARGC) [NR] = { #NAME, ARGC, sys_##NAME }
+
+/* System calls indexed by number.  Numbers without an entry are not
+ * implemented and kill the caller. */
+static const struct syscall_desc syscall_table[] = {
+	ENTRY (SYS_HALT, halt, 0),
+	ENTRY (SYS_EXIT, exit, 1),
+	ENTRY (SYS_FORK, fork, 1),
+	ENTRY (SYS_EXEC, exec, 1),
+	ENTRY (SYS_WAIT, wait, 1),
+	ENTRY (SYS_CREATE, create, 2),
+	ENTRY (SYS_REMOVE, remove, 1),
+	ENTRY (SYS_OPEN, open, 1),
+	ENTRY (SYS_FILESIZE, filesize, 1),
+	ENTRY (SYS_READ, read, 3),
+	ENTRY (SYS_WRITE, write, 3),
+	ENTRY (SYS_SEEK, seek, 2),
+	ENTRY (SYS_TELL, tell, 1),
+	ENTRY (SYS_CLOSE, close, 1),
+	ENTRY (SYS_DUP2, dup2, 2),
+	ENTRY (SYS_SPAWN, spawn, 3),
+	ENTRY (SYS_PREAD, pread, 4),
+	ENTRY (SYS_PWRITE, pwrite, 4),
+	ENTRY (SYS_READV, readv, 3),
+	ENTRY (SYS_WRITEV, writev, 3),
+	ENTRY (SYS_COPY_FILE_RANGE, copy_file_range, 5),
+	ENTRY (SYS_RING_SETUP, ring_setup, 1),
+	ENTRY (SYS_RING_ENTER, ring_enter, 1),
+	ENTRY (SYS_STRACE, strace, 1),
+	ENTRY (SYS_TTYMODE, ttymode, 1),
+	ENTRY (SYS_PIPE, pipe, 1),
+	ENTRY (SYS_SHM_OPEN, shm_open, 2),
+	ENTRY (SYS_SHM_MAP, shm_map, 2),
+	ENTRY (SYS_SHM_UNMAP, shm_unmap, 1),
+};
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+
+/* Number of latency histogram buckets.  Bucket I counts calls that
+ * took between 2**I and 2**(I+1) - 1 TSC cycles; the last bucket
+ * also counts everything slower. */
+#define LATENCY_BUCKETS 32
+
+/* Per-system call statistics. */
+struct syscall_stats {
+	uint64_t calls;             /* Number of calls. */
+	uint64_t timed;             /* Number of calls that returned. */
+	uint64_t cycles;            /* Total TSC cycles of TIMED calls. */
+	uint64_t latency[LATENCY_BUCKETS];  /* Histogram of TIMED calls. */
+};
+static struct syscall_stats syscall_stats[SYSCALL_CNT];
+
+/* Returns the name of system call NR. */
+const char *
+syscall_name (int nr) {
+	if (nr < 0 || (size_t) nr >= SYSCALL_CNT || syscall_table[nr].name == NULL)
+		return "unknown";
+	return syscall_table[nr].name;
+}
+
+/* Adds a call to NR that took CYCLES to the statistics. */
+static void
+syscall_account (int nr, uint64_t cycles) {
+	struct syscall_stats *st = &syscall_stats[nr];
+	int bucket = cycles > 0 ? 63 - __builtin_clzll (cycles) : 0;
+	enum intr_level old_level;
+
+	if (bucket >= LATENCY_BUCKETS)
+		bucket = LATENCY_BUCKETS - 1;
+
+	old_level = intr_disable ();
+	st->timed++;
+	st->cycles += cycles;
+	st->latency[bucket]++;
+	intr_set_level (old_level);
+}
+
+/* The main system call interface.  exit() and successful exec() do
+ * not return, so they are counted but neither timed nor traced. */
 void
-syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	// printf ("system call!\n");
-	// thread_exit ();
-	switch (f->R.rax) {
-		case SYS_HALT:
-			halt ();
-			break;
-		case SYS_EXIT:
-			exit (f->R.rdi);
-			break;
-		case SYS_FORK:
-			memcpy (&thread_current ()->ptf, f, sizeof (struct intr_frame));
-			f->R.rax = fork (f->R.rdi);
-			break;
-		case SYS_CREATE:
-			f->R.rax = create (f->R.rdi, f->R.rsi);
-			break;
-		case SYS_REMOVE:
-			f->R.rax = remove (f->R.rdi);
-			break;
-		case SYS_OPEN:
-			f->R.rax = open (f->R.rdi);
-			break;
-		case SYS_FILESIZE:
-			f->R.rax = filesize (f->R.rdi);
-			break;
-		case SYS_READ:
-			f->R.rax = read (f->R.rdi, f->R.rsi, f->R.rdx);
-			break;  
-		case SYS_WRITE:      
-			f->R.rax = write (f->R.rdi, f->R.rsi, f->R.rdx);
-			break;
-		case SYS_EXEC:
-			exec (f->R.rdi);
-			break;
-		case SYS_WAIT:
-			f->R.rax = wait (f->R.rdi);
-			break; 
-		case SYS_SEEK:
-			seek (f->R.rdi, f->R.rsi);
-			break;
-		case SYS_TELL:
-			f->R.rax = tell (f->R.rdi);
-			break;
-		case SYS_CLOSE:
-			close (f->R.rdi);
-			break;
-		default:
-			exit (-1);
-			break;
+syscall_handler (struct intr_frame *f) {
+	const uint64_t regs[SYSCALL_MAX_ARGS] = {
+		f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8, f->R.r9
+	};
+	uint64_t args[SYSCALL_MAX_ARGS] = { 0 };
+	const struct syscall_desc *desc;
+	uint64_t nr = f->R.rax;
+	uint64_t start, cycles, ret;
+	enum intr_level old_level;
+
+	if (nr >= SYSCALL_CNT || syscall_table[nr].func == NULL)
+		exit (-1);
+	desc = &syscall_table[nr];
+	memcpy (args, regs, desc->argc * sizeof *args);
+
+	old_level = intr_disable ();
+	syscall_stats[nr].calls++;
+	intr_set_level (old_level);
+
+	start = vdso_rdtsc ();
+	ret = desc->func (args, f);
+	cycles = vdso_rdtsc () - start;
+	syscall_account (nr, cycles);
+	if (strace_active ())
+		strace_record (nr, args, desc->argc, ret, start, cycles);
+	f->R.rax = ret;
+}
+
+/* Prints the number of calls to, and the latency of, each system call
+ * that was made. */
+void
+syscall_print_stats (void) {
+	for (size_t nr = 0; nr < SYSCALL_CNT; nr++) {
+		struct syscall_stats *st = &syscall_stats[nr];
+		if (st->calls == 0)
+			continue;
+
+		printf ("Syscall %s: %llu calls", syscall_table[nr].name, st->calls);
+		if (st->timed > 0) {
+			printf (", %llu cycles avg, log2 cycles:",
+					st->cycles / st->timed);
+			for (int i = 0; i < LATENCY_BUCKETS; i++)
+				if (st->latency[i] > 0)
+					printf (" %d:%llu", i, st->latency[i]);
+		}
+		printf ("\n");
 	}
 }
 
@@ -134,14 +264,38 @@ int wait (tid_t pid) {
   	return process_wait (pid);
 }
 
+int spawn (const char *cmd_line, const struct spawn_fd *fds, unsigned fd_cnt) {
+	check_address (cmd_line);
+	if (fd_cnt > SPAWN_FD_MAX)
+		return -1;
+	if (fd_cnt > 0) {
+		check_address (fds);
+		check_address ((uint8_t *) (fds + fd_cnt) - 1);
+	}
+	return process_spawn (cmd_line, fd_cnt > 0 ? fds : NULL, fd_cnt);
+}
+
 bool create (const char *file, unsigned initial_size) {
 	check_address (file);
 	return filesys_create (file, initial_size);
 }
 
 bool remove (const char *file) {
+	struct file *f;
+	bool success;
+
 	check_address (file);
-	return filesys_remove (file);
+
+	/* The exec cache holds executables open.  Make it let go of this
+	 * one, or its sectors stay allocated until the entry is evicted. */
+	f = filesys_open (file);
+	success = filesys_remove (file);
+	if (f != NULL) {
+		if (success)
+			execcache_forget (file_get_inode (f));
+		file_close (f);
+	}
+	return success;
 }
 
 int open (const char *file) {
@@ -149,92 +303,317 @@ int open (const char *file) {
 	struct thread *cur = thread_current ();
 	struct file *fd = filesys_open (file);
 	if (fd) {
-		for (int i = 2; i < 128; i++) {
-			if (!cur->fdt[i]) {
-				cur->fdt[i] = fd;
-				cur->next_fd = i + 1;
-				return i;
-			}
-		}
+		int i = fdt_alloc (&cur->fdt, fd);
+		if (i >= 0)
+			return i;
 		file_close(fd);
 	}
 	return -1;
 }
 
 int filesize (int fd) {
-	struct file *file = thread_current ()->fdt[fd];
-	if (file)
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file && !fdt_is_console (file))
 		return file_length (file);
 	return -1;
 }
 
 int read (int fd, void *buffer, unsigned size) {
 	check_address (buffer);
-	if (fd == 1) {
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file == NULL || file == STDOUT_FILE) {
 		return -1;
 	}
 
-	if (fd == 0) {
-		lock_acquire (&filesys_lock);
-		int byte = input_getc ();
-		lock_release (&filesys_lock);
-		return byte;
-	}
-	struct file *file = thread_current ()->fdt[fd];
-	if (file) {
-		lock_acquire (&filesys_lock);
-		int read_byte = file_read (file, buffer, size);
-		lock_release (&filesys_lock);
-		return read_byte;
-	}
-	return -1;
+	if (file == STDIN_FILE)
+		return input_read (buffer, size);
+
+	return file_read (file, buffer, size);
 }
 
 int write (int fd UNUSED, const void *buffer, unsigned size) {
 	check_address (buffer);
-
-	if (fd == 0)
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file == NULL || file == STDIN_FILE)
 		return -1;
 
-	if (fd == 1) {
-		lock_acquire (&filesys_lock);
+	if (file == STDOUT_FILE) {
 		putbuf (buffer, size);
-		lock_release (&filesys_lock);
 		return size;
 	}
 
-	struct file *file = thread_current ()->fdt[fd];
-	if (file) {
-		lock_acquire (&filesys_lock);
-		int write_byte = file_write (file, buffer, size);
-		lock_release (&filesys_lock);
-		return write_byte;
-	}
+	return file_write (file, buffer, size);
 }
 
 void seek (int fd, unsigned position) {
-	struct file *curfile = thread_current ()->fdt[fd];
-	if (curfile)
+	struct file *curfile = fdt_get (&thread_current ()->fdt, fd);
+	if (curfile && !fdt_is_console (curfile))
 		file_seek (curfile, position);
 }
 
 unsigned tell (int fd) {
-	struct file *curfile = thread_current ()->fdt[fd];
-	if (curfile)
+	struct file *curfile = fdt_get (&thread_current ()->fdt, fd);
+	if (curfile && !fdt_is_console (curfile))
 		return file_tell (curfile);
+	return -1;
 }
 
 void close (int fd) {
-	struct file * file = thread_current ()->fdt[fd];
-	if (file) {
-		lock_acquire (&filesys_lock);
-		thread_current ()->fdt[fd] = NULL;
+	struct file *file = fdt_remove (&thread_current ()->fdt, fd);
+	if (file && !fdt_is_console (file))
 		file_close (file);
-		lock_release (&filesys_lock);
+}
+
+int dup2 (int oldfd, int newfd) {
+	struct thread *cur = thread_current ();
+	struct file *file = fdt_get (&cur->fdt, oldfd);
+
+	if (file == NULL || newfd < 0)
+		return -1;
+	if (oldfd == newfd)
+		return newfd;
+
+	/* Both descriptors refer to one open file and share its position. */
+	if (!fdt_is_console (file))
+		file_dup (file);
+	bool success = fdt_install (&cur->fdt, newfd, file);
+	if (!success && !fdt_is_console (file))
+		file_close (file);
+	return success ? newfd : -1;
+}
+
+/* Creates a pipe and stores descriptors for its read and write ends
+ * in FDS[0] and FDS[1].  Returns 0 if successful, -1 otherwise. */
+int pipe (int *fds) {
+	struct thread *cur = thread_current ();
+	struct file *read_end, *write_end;
+
+	check_address (fds);
+	check_address (fds + 1);
+	if (!file_open_pipe (&read_end, &write_end))
+		return -1;
+
+	fds[0] = fdt_alloc (&cur->fdt, read_end);
+	if (fds[0] < 0) {
+		file_close (read_end);
+		file_close (write_end);
+		return -1;
+	}
+	fds[1] = fdt_alloc (&cur->fdt, write_end);
+	if (fds[1] < 0) {
+		file_close (fdt_remove (&cur->fdt, fds[0]));
+		file_close (write_end);
+		return -1;
+	}
+	return 0;
+}
+
+int pread (int fd, void *buffer, unsigned size, off_t ofs) {
+	check_address (buffer);
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file == NULL || fdt_is_console (file) || ofs < 0)
+		return -1;
+	return file_read_at (file, buffer, size, ofs);
+}
+
+int pwrite (int fd, const void *buffer, unsigned size, off_t ofs) {
+	check_address (buffer);
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file == NULL || fdt_is_console (file) || ofs < 0)
+		return -1;
+	return file_write_at (file, buffer, size, ofs);
+}
+
+/* Copies the IOV_CNT-element iovec array at user address UIOV into
+ * kernel memory and checks every buffer in it.  Returns the copy,
+ * which the caller must free(), or a null pointer if IOV_CNT is out
+ * of range or the buffers add up to more than fits in an int. */
+static struct iovec *
+copy_in_iov (const struct iovec *uiov, int iov_cnt) {
+	struct iovec *iov;
+	size_t total = 0;
+
+	if (iov_cnt <= 0 || iov_cnt > IOV_MAX)
+		return NULL;
+	check_address (uiov);
+	check_address ((uint8_t *) (uiov + iov_cnt) - 1);
+
+	iov = malloc (iov_cnt * sizeof *iov);
+	if (iov == NULL)
+		return NULL;
+	memcpy (iov, uiov, iov_cnt * sizeof *iov);
+
+	for (int i = 0; i < iov_cnt; i++) {
+		total += iov[i].iov_len;
+		if (iov[i].iov_len > INT_MAX || total > INT_MAX) {
+			free (iov);
+			return NULL;
+		}
+		if (iov[i].iov_len > 0) {
+			check_address (iov[i].iov_base);
+			check_address ((uint8_t *) iov[i].iov_base + iov[i].iov_len - 1);
+		}
+	}
+	return iov;
+}
+
+int readv (int fd, const struct iovec *uiov, int iov_cnt) {
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	struct iovec *iov;
+	int bytes_read = 0;
+
+	if (file == NULL || file == STDOUT_FILE)
+		return -1;
+	if (iov_cnt == 0)
+		return 0;
+	iov = copy_in_iov (uiov, iov_cnt);
+	if (iov == NULL)
+		return -1;
+
+	if (file == STDIN_FILE) {
+		/* Wait only until some input arrives, and stop at the first
+		 * short read, so that a readv() that got some input never
+		 * blocks for more. */
+		for (int i = 0; i < iov_cnt; i++) {
+			size_t n = bytes_read == 0
+				? input_read (iov[i].iov_base, iov[i].iov_len)
+				: input_read_nowait (iov[i].iov_base, iov[i].iov_len);
+			bytes_read += n;
+			if (n < iov[i].iov_len)
+				break;
+		}
+	} else
+		bytes_read = file_readv (file, iov, iov_cnt);
+
+	free (iov);
+	return bytes_read;
+}
+
+int writev (int fd, const struct iovec *uiov, int iov_cnt) {
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	struct iovec *iov;
+	int bytes_written = 0;
+
+	if (file == NULL || file == STDIN_FILE)
+		return -1;
+	if (iov_cnt == 0)
+		return 0;
+	iov = copy_in_iov (uiov, iov_cnt);
+	if (iov == NULL)
+		return -1;
+
+	if (file == STDOUT_FILE) {
+		for (int i = 0; i < iov_cnt; i++) {
+			putbuf (iov[i].iov_base, iov[i].iov_len);
+			bytes_written += iov[i].iov_len;
+		}
+	} else
+		bytes_written = file_writev (file, iov, iov_cnt);
+
+	free (iov);
+	return bytes_written;
+}
+
+/* Writes up to LENGTH bytes of IN, starting at OFS, to the console.
+ * Returns the number of bytes written. */
+static int
+copy_to_console (struct file *in, off_t ofs, unsigned length) {
+	char *buf = palloc_get_page (0);
+	int copied = 0;
+
+	if (buf == NULL)
+		return -1;
+	while (length > 0) {
+		off_t chunk = length < PGSIZE ? length : PGSIZE;
+		off_t n = file_read_at (in, buf, chunk, ofs + copied);
+		if (n <= 0)
+			break;
+		putbuf (buf, n);
+		copied += n;
+		length -= n;
 	}
+	palloc_free_page (buf);
+	return copied;
+}
+
+/* Copies up to LENGTH bytes from FD_IN to FD_OUT without passing
+ * them through user memory.  A null OFF_IN or OFF_OUT means the
+ * descriptor's file position, which is used and advanced; otherwise
+ * the copy starts at *OFF_IN or *OFF_OUT, which is updated and the
+ * file position left alone.  FD_OUT may be the console, as with
+ * sendfile().  Returns the number of bytes copied, or -1. */
+int copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+		unsigned length) {
+	struct thread *cur = thread_current ();
+	struct file *in = fdt_get (&cur->fdt, fd_in);
+	struct file *out = fdt_get (&cur->fdt, fd_out);
+	off_t in_ofs, out_ofs;
+	int copied;
+
+	if (in == NULL || fdt_is_console (in) || out == NULL || out == STDIN_FILE)
+		return -1;
+	if (off_in != NULL)
+		check_address (off_in);
+	if (off_out != NULL)
+		check_address (off_out);
+	if (length > INT_MAX)
+		length = INT_MAX;
+
+	in_ofs = off_in != NULL ? *off_in : file_tell (in);
+	if (in_ofs < 0)
+		return -1;
+
+	if (out == STDOUT_FILE) {
+		copied = copy_to_console (in, in_ofs, length);
+		if (copied < 0)
+			return -1;
+	} else {
+		out_ofs = off_out != NULL ? *off_out : file_tell (out);
+		if (out_ofs < 0)
+			return -1;
+		/* Overlapping ranges of one file would read back what we
+		 * just wrote.  Compare in 64 bits, since an offset plus
+		 * LENGTH may not fit in an off_t. */
+		if (file_get_inode (in) == file_get_inode (out)
+				&& (int64_t) in_ofs < (int64_t) out_ofs + length
+				&& (int64_t) out_ofs < (int64_t) in_ofs + length)
+			return -1;
+		copied = file_copy_range (in, in_ofs, out, out_ofs, length);
+		if (copied < 0)
+			return -1;
+		if (off_out != NULL)
+			*off_out = out_ofs + copied;
+		else
+			file_seek (out, out_ofs + copied);
+	}
+
+	if (off_in != NULL)
+		*off_in = in_ofs + copied;
+	else
+		file_seek (in, in_ofs + copied);
+	return copied;
+}
+
+/* Makes sure FD's data has reached the disk by writing back its
+ * dirty sectors in the buffer cache. */
+int fsync (int fd) {
+	struct file *file = fdt_get (&thread_current ()->fdt, fd);
+	if (file == NULL || fdt_is_console (file))
+		return -1;
+	if (!file_is_pipe (file))
+		inode_flush (file_get_inode (file));
+	return 0;
+}
+
+/* Sets the console input mode to MODE, one of enum tty_mode.
+ * Returns the previous mode, or -1 if MODE is invalid. */
+int ttymode (int mode) {
+	if (mode != TTY_RAW && mode != TTY_CANON)
+		return -1;
+	return input_set_mode (mode);
 }
 
-void check_address (void *addr) {
+void check_address (const void *addr) {
 	struct thread *cur = thread_current ();
 	if (addr == NULL || is_kernel_vaddr(addr) || pml4_get_page (cur->pml4, addr) == NULL)
 		exit (-1);
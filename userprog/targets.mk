@@ -4,3 +4,10 @@ userprog_SRC += userprog/syscall-entry.S # System call entry.
 userprog_SRC += userprog/syscall.c	# System call handler.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
+userprog_SRC += userprog/fdtable.c	# File descriptor tables.
+userprog_SRC += userprog/textcache.c	# Shared executable text pages.
+userprog_SRC += userprog/execcache.c	# Parsed ELF header cache.
+userprog_SRC += userprog/ring.c		# Batched I/O rings.
+userprog_SRC += userprog/vdso.c		# Kernel data pages mapped into processes.
+userprog_SRC += userprog/strace.c	# System call tracing.
+userprog_SRC += userprog/shm.c		# Shared memory segments.
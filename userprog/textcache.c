@@ -0,0 +1,241 @@
+#include "userprog/textcache.h"
+#include <debug.h>
+#include <hash.h>
+#include <string.h>
+#include "devices/disk.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Read-only pages of executables, shared between processes.
+
+   A page of a non-writable PT_LOAD segment is identified by the
+   executable's inode sector, the page's file offset and the number of
+   bytes it takes from the file.  Processes running the same binary map
+   one frame for each such page instead of reading a private copy.
+   Shared mappings carry PTE_TEXT in the page table, so that fork() can
+   share them as well and process teardown can hand them back here
+   before pml4_destroy() would free the frame.
+
+   A page is freed as soon as its last mapping goes away.  Every
+   process that maps a page keeps its executable open with writes
+   denied, so a cached page cannot go stale. */
+
+struct text_page {
+	disk_sector_t sector;       /* Executable's inode sector. */
+	off_t ofs;                  /* File offset of the page. */
+	size_t read_bytes;          /* Bytes read from the file; rest is 0. */
+	void *kpage;                /* Frame holding the contents. */
+	int map_cnt;                /* Page tables that map KPAGE. */
+	struct hash_elem key_elem;  /* Element in text_pages. */
+	struct hash_elem kpage_elem;/* Element in text_frames. */
+};
+
+static struct hash text_pages;  /* Indexed by (sector, ofs, read_bytes). */
+static struct hash text_frames; /* Indexed by kpage. */
+static struct lock text_lock;   /* Protects both tables. */
+
+static hash_hash_func key_hash, kpage_hash;
+static hash_less_func key_less, kpage_less;
+static bool map_page (uint64_t *pml4, void *upage, struct text_page *);
+static void release_page (struct text_page *);
+static bool unmap_pte (uint64_t *pte, void *va, void *aux);
+
+/* Initializes the text page cache. */
+void
+textcache_init (void) {
+	hash_init (&text_pages, key_hash, key_less, NULL);
+	hash_init (&text_frames, kpage_hash, kpage_less, NULL);
+	lock_init (&text_lock);
+}
+
+/* Maps UPAGE in PML4 read-only to the page of FILE that starts at
+ * offset OFS, of which READ_BYTES bytes come from FILE and the rest
+ * is zeroed.  The page is read from FILE only if no other process has
+ * it mapped already.  Returns false if UPAGE is already mapped or
+ * memory is exhausted. */
+bool
+textcache_map (uint64_t *pml4, void *upage, struct file *file,
+		off_t ofs, size_t read_bytes) {
+	struct text_page key, *p;
+	struct hash_elem *e;
+	void *kpage;
+	bool success = false;
+
+	ASSERT (read_bytes <= PGSIZE);
+	ASSERT (ofs % PGSIZE == 0);
+
+	if (pml4_get_page (pml4, upage) != NULL)
+		return false;
+
+	key.sector = inode_get_inumber (file_get_inode (file));
+	key.ofs = ofs;
+	key.read_bytes = read_bytes;
+
+	lock_acquire (&text_lock);
+	e = hash_find (&text_pages, &key.key_elem);
+	if (e != NULL) {
+		success = map_page (pml4, upage,
+				hash_entry (e, struct text_page, key_elem));
+		lock_release (&text_lock);
+		return success;
+	}
+	lock_release (&text_lock);
+
+	/* First mapping: read the page in without holding TEXT_LOCK, so
+	 * that other processes' page-ins do not wait for this disk read. */
+	kpage = palloc_get_page (PAL_USER);
+	if (kpage == NULL)
+		return false;
+	if (file_read_at (file, kpage, read_bytes, ofs) != (off_t) read_bytes) {
+		palloc_free_page (kpage);
+		return false;
+	}
+	memset ((uint8_t *) kpage + read_bytes, 0, PGSIZE - read_bytes);
+
+	lock_acquire (&text_lock);
+	e = hash_find (&text_pages, &key.key_elem);
+	if (e != NULL) {
+		/* Someone else read the same page in the meantime. */
+		p = hash_entry (e, struct text_page, key_elem);
+		palloc_free_page (kpage);
+	} else {
+		p = malloc (sizeof *p);
+		if (p == NULL) {
+			palloc_free_page (kpage);
+			goto done;
+		}
+		*p = key;
+		p->kpage = kpage;
+		p->map_cnt = 0;
+		hash_insert (&text_pages, &p->key_elem);
+		hash_insert (&text_frames, &p->kpage_elem);
+	}
+
+	success = map_page (pml4, upage, p);
+	if (!success && p->map_cnt == 0)
+		release_page (p);
+
+done:
+	lock_release (&text_lock);
+	return success;
+}
+
+/* Maps UPAGE in PML4 to the same shared text page as PARENT_PTE, a
+ * PTE_TEXT entry of the process being forked.  Returns false if
+ * memory is exhausted. */
+bool
+textcache_fork (uint64_t *pml4, void *upage, uint64_t *parent_pte) {
+	struct text_page key;
+	struct hash_elem *e;
+	bool success;
+
+	ASSERT (*parent_pte & PTE_TEXT);
+
+	key.kpage = ptov (PTE_ADDR (*parent_pte));
+	lock_acquire (&text_lock);
+	e = hash_find (&text_frames, &key.kpage_elem);
+	ASSERT (e != NULL);
+	success = map_page (pml4, upage,
+			hash_entry (e, struct text_page, kpage_elem));
+	lock_release (&text_lock);
+	return success;
+}
+
+/* Removes every shared text mapping from PML4, freeing pages that
+ * are no longer mapped anywhere.  Must be called before PML4 is
+ * passed to pml4_destroy(), which would otherwise free shared frames,
+ * and while PML4 is not active. */
+void
+textcache_unmap_all (uint64_t *pml4) {
+	lock_acquire (&text_lock);
+	pml4_for_each (pml4, unmap_pte, NULL);
+	lock_release (&text_lock);
+}
+
+/* Maps UPAGE in PML4 to P's frame and counts the mapping. */
+static bool
+map_page (uint64_t *pml4, void *upage, struct text_page *p) {
+	uint64_t *pte;
+
+	ASSERT (lock_held_by_current_thread (&text_lock));
+
+	if (!pml4_set_page (pml4, upage, p->kpage, false))
+		return false;
+	pte = pml4e_walk (pml4, (uint64_t) upage, 0);
+	*pte |= PTE_TEXT;
+	p->map_cnt++;
+	return true;
+}
+
+/* Frees P if nothing maps it any more. */
+static void
+release_page (struct text_page *p) {
+	ASSERT (lock_held_by_current_thread (&text_lock));
+
+	if (p->map_cnt > 0)
+		return;
+	hash_delete (&text_pages, &p->key_elem);
+	hash_delete (&text_frames, &p->kpage_elem);
+	palloc_free_page (p->kpage);
+	free (p);
+}
+
+/* pml4_for_each() helper for textcache_unmap_all(). */
+static bool
+unmap_pte (uint64_t *pte, void *va, void *aux UNUSED) {
+	struct text_page key;
+	struct hash_elem *e;
+	struct text_page *p;
+
+	if (!is_user_vaddr (va) || !(*pte & PTE_TEXT))
+		return true;
+
+	key.kpage = ptov (PTE_ADDR (*pte));
+	e = hash_find (&text_frames, &key.kpage_elem);
+	ASSERT (e != NULL);
+	*pte = 0;
+
+	p = hash_entry (e, struct text_page, kpage_elem);
+	p->map_cnt--;
+	release_page (p);
+	return true;
+}
+
+static uint64_t
+key_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_page *p = hash_entry (e, struct text_page, key_elem);
+	return hash_int (p->sector) ^ hash_int (p->ofs / PGSIZE)
+		^ hash_int (p->read_bytes);
+}
+
+static bool
+key_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct text_page *a = hash_entry (a_, struct text_page, key_elem);
+	const struct text_page *b = hash_entry (b_, struct text_page, key_elem);
+
+	if (a->sector != b->sector)
+		return a->sector < b->sector;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	return a->read_bytes < b->read_bytes;
+}
+
+static uint64_t
+kpage_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct text_page *p = hash_entry (e, struct text_page, kpage_elem);
+	return hash_bytes (&p->kpage, sizeof p->kpage);
+}
+
+static bool
+kpage_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct text_page, kpage_elem)->kpage
+		< hash_entry (b, struct text_page, kpage_elem)->kpage;
+}
@@ -0,0 +1,79 @@
+#include "userprog/vdso.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* The time page, shared by every process. */
+static struct vdso_time *time_page;
+
+/* Tick and TSC value at the first update, for calibration. */
+static int64_t first_ticks;
+static uint64_t first_tsc;
+
+/* Allocates the time page.  Must be called before the timer starts
+ * interrupting, i.e. before thread_start(). */
+void
+vdso_init (void) {
+	ASSERT (sizeof (struct vdso_time) <= PGSIZE);
+
+	time_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	time_page->timer_freq = TIMER_FREQ;
+}
+
+/* Publishes TICKS, the new tick count, on the time page.  Called from
+ * the timer interrupt handler.  TSC_PER_TICK is averaged over every
+ * tick since the first, so it settles as the system runs. */
+void
+vdso_update (int64_t ticks) {
+	uint64_t tsc = vdso_rdtsc ();
+
+	if (time_page == NULL)
+		return;
+	if (first_tsc == 0) {
+		first_ticks = ticks;
+		first_tsc = tsc;
+	}
+
+	time_page->seq++;
+	barrier ();
+	time_page->ticks = ticks;
+	time_page->tick_tsc = tsc;
+	if (ticks > first_ticks)
+		time_page->tsc_per_tick = (tsc - first_tsc) / (ticks - first_ticks);
+	barrier ();
+	time_page->seq++;
+}
+
+/* Maps the time page and a new process page for T into T's address
+ * space, both read-only.  Returns false if memory is exhausted. */
+bool
+vdso_map (struct thread *t) {
+	struct vdso_proc *proc;
+
+	proc = palloc_get_page (PAL_USER | PAL_ZERO);
+	if (proc == NULL)
+		return false;
+	proc->pid = t->tid;
+	if (!pml4_set_page (t->pml4, VDSO_PROC_UADDR, proc, false)) {
+		palloc_free_page (proc);
+		return false;
+	}
+	return pml4_set_page (t->pml4, VDSO_TIME_UADDR, time_page, false);
+}
+
+/* Removes the time page from PML4, so that pml4_destroy() does not
+ * free it.  The process page is freed along with the page table. */
+void
+vdso_unmap (uint64_t *pml4) {
+	pml4_clear_page (pml4, VDSO_TIME_UADDR);
+}
+
+/* Returns true if VA is one of the kernel data pages, which fork()
+ * maps afresh rather than copying. */
+bool
+vdso_is_page (void *va) {
+	return va == VDSO_TIME_UADDR || va == VDSO_PROC_UADDR;
+}